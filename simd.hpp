@@ -1,4 +1,9 @@
 #pragma once
+#include <type_traits>
+#include <cstddef>
+#include <atomic>
+#include <thread>
+#include <stdexcept>
 
 namespace simd
 {
@@ -7,29 +12,172 @@ namespace simd
 	class Step_Singlethreaded {};
 	class Step_Accumulate {};
 	class Step_AccReset {};
+	class Step_Scan {};
 
-	template<class DataBatch> struct Fold
+	namespace avx512
 	{
+		// registers per iteration in the loops of AVX-512 arrays larger than 1KB: 1, 2, 4 or 8.
+		// Per thread: a Dispatcher with Unroll() set puts its factor on its threads for the length of a Run.
+		inline thread_local int unroll = 4;
+	}
+
+	namespace monoid
+	{
+		// Reduction used by Fold steps: partials of type Partial<DataBatch> are merged with combine(),
+		// the final partial is turned into Result<Scalar> by finish(). More monoids live in simd_reduce.hpp.
+		struct sum
+		{
+			template<class DataBatch> using Partial = DataBatch;
+			template<class Scalar>    using Result  = Scalar;
+
+			template<class DataBatch> static void combine(DataBatch& lhs, const DataBatch& rhs) { lhs += rhs; }
+			// undoes combine(lhs, rhs); monoids that have it are updated in place by incremental Runs
+			template<class DataBatch> static void uncombine(DataBatch& lhs, const DataBatch& rhs) { lhs -= rhs; }
+			template<class DataBatch, class Scalar> static void finish(const DataBatch& src, Scalar& target) { target = src.fold(); }
+			template<class Scalar> static Scalar identity() { return Scalar{}; }
+		};
+	}
+
+	template<class DataBatch, class Op = monoid::sum> struct Fold
+	{
+		using Monoid = Op;
+
+		int next_step;
+		typename Op::template Partial<DataBatch>*                           merge_source;
+		typename Op::template Result<typename DataBatch::ScalarType>*       merge_target;
+	};
+
+	template<class DataBatch, class Op = monoid::sum> struct FoldAcc
+	{
+		using Monoid = Op;
+
 		int next_step;
-		DataBatch*                         merge_source;
-		typename DataBatch::ScalarType*    merge_target;
+		typename Op::template Partial<DataBatch>*                           merge_source;
+		typename Op::template Result<typename DataBatch::ScalarType>*       merge_target;
+	};
+
+	// Result of a FoldAsync step, ready once the reduction running behind the following steps is done.
+	// Keep it per thread (Accumulator) or per instance: the Dispatcher arms it with the fold's generation.
+	// Not ready before the first FoldAsync step has armed it; wait() and get() throw then.
+	template<class Result> class FoldFuture
+	{
+		const std::atomic<int>* done = nullptr;
+		int generation = 0;
+		const Result* value = nullptr;
+		bool is_armed = false;
+	public:
+		void arm(const std::atomic<int>* d, int g, const Result* v)
+		{
+			done = d;
+			generation = g;
+			value = v;
+			is_armed = true;
+		}
+
+		// already merged into v
+		void arm(const Result* v)
+		{
+			done = nullptr;
+			value = v;
+			is_armed = true;
+		}
+
+		bool armed() const { return is_armed; }
+
+		bool ready() const { return is_armed && (!done || done->load(std::memory_order_acquire) >= generation); }
+
+		void wait() const
+		{
+			if (!is_armed)
+				throw std::logic_error("FoldFuture: not armed by a FoldAsync step yet");
+			while (!ready())
+				std::this_thread::yield();
+		}
+
+		const Result& get() const
+		{
+			wait();
+			return *value;
+		}
 	};
 
-	template<class DataBatch> struct FoldAcc
+	// Fold whose threads do not wait for the merge: each copies its partial into a double buffer and goes on,
+	// the last one to arrive merges the buffers in thread order and finishes into merge_target.
+	// Read merge_target through future (may be nullptr) in a later step.
+	template<class DataBatch, class Op = monoid::sum> struct FoldAsync
 	{
+		using Monoid = Op;
+		using Result = typename Op::template Result<typename DataBatch::ScalarType>;
+
 		int next_step;
-		DataBatch*                         merge_source;
-		typename DataBatch::ScalarType*    merge_target;
+		typename Op::template Partial<DataBatch>*                           merge_source;
+		Result*                                                             merge_target;
+		FoldFuture<Result>*                                                 future;
 	};
 
 	struct FoldMultiTag {};
-	template<class DataBatch, class SourceContainer, class TargetContainer> struct FoldMulti : public FoldMultiTag
+	template<class DataBatch, class SourceContainer, class TargetContainer, class Op = monoid::sum> struct FoldMulti : public FoldMultiTag
 	{
+		using Monoid = Op;
+
 		int next_step;
 		SourceContainer* merge_source;
 		TargetContainer* merge_target;
 	};
 
+	// Step_Scan result: after the step, *carry of every instance is set to the combination of the totals of
+	// all instances before it in batch order (identity for the first). A typical scan reduces its batch into
+	// *total here and applies the carry in the next step, e.g. batch.inclusive_scan(carry).
+	// Op::combine must accept scalars, Op::identity<Scalar>() gives the neutral element.
+	template<class DataBatch, class Op = monoid::sum> struct Scan
+	{
+		using Monoid = Op;
+
+		int next_step;
+		typename DataBatch::ScalarType* total;
+		typename DataBatch::ScalarType* carry;
+	};
+
+	// Parallel step result that can end an iteration without a barrier: each instance votes done or not,
+	// and once every instance voted done in one round (or the Dispatcher's budget ran out, or it was cancelled)
+	// all threads go to exit_step instead of next_step. Votes of a round are read in the next round,
+	// so the step runs once more after the round that decided.
+	struct Vote
+	{
+		int  next_step;
+		int  exit_step;
+		bool done;
+	};
+
+	// Combines the in-process Fold result with other processes before finish(), see shm::Communicator.
+	// combine(lhs, rhs) is Op::combine on two copies of the partial.
+	struct ReduceGroup
+	{
+		using Combine = void(*)(void* lhs, const void* rhs);
+
+		virtual void allreduce(void* partial, size_t bytes, Combine combine) = 0;
+		virtual ~ReduceGroup() = default;
+	};
+
+	template<class T> struct is_fold : std::false_type {};
+	template<class DataBatch, class Op> struct is_fold<Fold<DataBatch, Op>> : std::true_type {};
+
+	template<class T> struct is_fold_async : std::false_type {};
+	template<class DataBatch, class Op> struct is_fold_async<FoldAsync<DataBatch, Op>> : std::true_type {};
+
+	template<class T> struct is_fold_acc : std::false_type {};
+	template<class DataBatch, class Op> struct is_fold_acc<FoldAcc<DataBatch, Op>> : std::true_type {};
+
+	template<class T> struct is_scan : std::false_type {};
+	template<class DataBatch, class Op> struct is_scan<Scan<DataBatch, Op>> : std::true_type {};
+
+	template<class Op, class Partial, class = void> struct is_invertible : std::false_type {};
+	template<class Op, class Partial> struct is_invertible<Op, Partial,
+		std::void_t<decltype(Op::uncombine(std::declval<Partial&>(), std::declval<const Partial&>()))>> : std::true_type {};
+
+	template<class T> struct is_vote : std::false_type {};
+	template<> struct is_vote<Vote> : std::true_type {};
+
 	template<int STEP, class Tag = Step_Parallel> class StepTag {};
 	template<int STEP> struct StepTag<STEP, Step_Separate>
 	{
@@ -0,0 +1,167 @@
+#pragma once
+#include <memory_resource>
+#include <mutex>
+#include <array>
+#include <new>
+#include <cstddef>
+#include <cstdint>
+
+#include <sys/mman.h>
+
+namespace simd
+{
+	// Pool of 64-byte aligned blocks carved out of 2MB-aligned huge page chunks.
+	// Blocks are rounded up to a power of two and recycled through per-size free lists,
+	// memory only goes back to the system when the arena is destroyed or release() is called.
+	class HugePageArena : public std::pmr::memory_resource
+	{
+	public:
+		static const size_t huge_page = size_t(2) << 20;
+		static const size_t min_block = 64;
+
+		explicit HugePageArena(size_t chunk_bytes = 16 * huge_page, bool use_hugetlb = false)
+			: chunk_size(round_up(chunk_bytes, huge_page)), hugetlb(use_hugetlb)
+		{}
+
+		HugePageArena(const HugePageArena&) = delete;
+		HugePageArena& operator=(const HugePageArena&) = delete;
+
+		~HugePageArena()
+		{
+			release();
+		}
+
+		void release()
+		{
+			std::lock_guard<std::mutex> l(m);
+			while (chunks)
+			{
+				Chunk* next = chunks->next;
+				::munmap(chunks, chunks->length);
+				chunks = next;
+			}
+			free_lists.fill(nullptr);
+			cursor = limit = nullptr;
+			mapped = 0;
+		}
+
+		size_t reserved() const { return mapped; }
+
+	private:
+		struct Chunk
+		{
+			Chunk* next;
+			size_t length;
+		};
+
+		struct FreeBlock
+		{
+			FreeBlock* next;
+		};
+
+		static size_t round_up(size_t x, size_t a) { return (x + a - 1) / a * a; }
+
+		static int size_class(size_t bytes)
+		{
+			int k = 0;
+			while ((min_block << k) < bytes)
+				++k;
+			return k;
+		}
+
+		Chunk* map_chunk(size_t bytes)
+		{
+			bytes = round_up(bytes, huge_page);
+			void* p = MAP_FAILED;
+
+			if (hugetlb)
+				p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+			if (p == MAP_FAILED)
+			{
+				// over-map by one huge page and trim, so THP can back the whole range
+				char* raw = static_cast<char*>(::mmap(nullptr, bytes + huge_page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+				if (raw == MAP_FAILED)
+					throw std::bad_alloc{};
+
+				char* aligned = reinterpret_cast<char*>(round_up(reinterpret_cast<uintptr_t>(raw), huge_page));
+				if (aligned != raw)
+					::munmap(raw, aligned - raw);
+				if (aligned + bytes != raw + bytes + huge_page)
+					::munmap(aligned + bytes, (raw + bytes + huge_page) - (aligned + bytes));
+
+				::madvise(aligned, bytes, MADV_HUGEPAGE);
+				p = aligned;
+			}
+
+			Chunk* c = static_cast<Chunk*>(p);
+			c->next = chunks;
+			c->length = bytes;
+			chunks = c;
+			mapped += bytes;
+			return c;
+		}
+
+		void* do_allocate(size_t bytes, size_t alignment) override
+		{
+			if (alignment < min_block)
+				alignment = min_block;
+
+			int k = size_class(bytes);
+			size_t block = min_block << k;
+
+			std::lock_guard<std::mutex> l(m);
+
+			if (free_lists[k] && reinterpret_cast<uintptr_t>(free_lists[k]) % alignment == 0)
+			{
+				FreeBlock* b = free_lists[k];
+				free_lists[k] = b->next;
+				return b;
+			}
+
+			// blocks bigger than half a chunk get a chunk of their own
+			if (block + alignment > chunk_size / 2)
+			{
+				Chunk* c = map_chunk(block + alignment);
+				return reinterpret_cast<char*>(c) + alignment;
+			}
+
+			char* p = reinterpret_cast<char*>(round_up(reinterpret_cast<uintptr_t>(cursor), alignment));
+			if (!cursor || p + block > limit)
+			{
+				Chunk* c = map_chunk(chunk_size);
+				cursor = reinterpret_cast<char*>(c) + sizeof(Chunk);
+				limit = reinterpret_cast<char*>(c) + c->length;
+				p = reinterpret_cast<char*>(round_up(reinterpret_cast<uintptr_t>(cursor), alignment));
+			}
+
+			cursor = p + block;
+			return p;
+		}
+
+		void do_deallocate(void* p, size_t bytes, size_t) override
+		{
+			int k = size_class(bytes);
+
+			std::lock_guard<std::mutex> l(m);
+			FreeBlock* b = static_cast<FreeBlock*>(p);
+			b->next = free_lists[k];
+			free_lists[k] = b;
+		}
+
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+		{
+			return this == &other;
+		}
+
+		std::mutex m;
+		std::array<FreeBlock*, 48> free_lists{};
+		Chunk* chunks = nullptr;
+		char*  cursor = nullptr;
+		char*  limit = nullptr;
+
+		size_t chunk_size;
+		bool   hugetlb;
+		size_t mapped = 0;
+	};
+}
@@ -5,8 +5,14 @@
 #include <algorithm>
 #include <functional>
 
+#include "simd.hpp"
+
 #include <immintrin.h>
 #include <cstdlib>
+#include <cstdint>
+#include <stdexcept>
+#include <memory_resource>
+#include <utility>
 
 namespace simd
 {
@@ -75,6 +81,12 @@ namespace simd
 			__m512d operator()(const __m512d a, const __m512d b) const { return _mm512_div_pd(b, a); }
 		};
 
+		struct fmadd
+		{
+			__m512  operator()(const __m512  a, const __m512  b, const __m512  c) const { return _mm512_fmadd_ps(a, b, c); }
+			__m512d operator()(const __m512d a, const __m512d b, const __m512d c) const { return _mm512_fmadd_pd(a, b, c); }
+		};
+
 		struct fill
 		{
 			__m512  operator()(const __m512  a, const __m512  b) const { return b; }
@@ -98,6 +110,84 @@ namespace simd
 		void store(__m512d* a, const __m512d& v) { _mm512_storeu_pd(a, v); }
 		void store(__m512i* a, const __m512i& v) { _mm512_storeu_epi32(a, v); }
 
+		inline __m512  load_aligned(const __m512* a) { return _mm512_load_ps(a); }
+		inline __m512d load_aligned(const __m512d* a) { return _mm512_load_pd(a); }
+		inline __m512i load_aligned(const __m512i* a) { return _mm512_load_si512(a); }
+
+		inline void stream(__m512*  a, const __m512& v) { _mm512_stream_ps(reinterpret_cast<float*>(a), v); }
+		inline void stream(__m512d* a, const __m512d& v) { _mm512_stream_pd(reinterpret_cast<double*>(a), v); }
+		inline void stream(__m512i* a, const __m512i& v) { _mm512_stream_si512(a, v); }
+
+		// the first n lanes only (n below the lane count): the rest load as zero and are not stored
+		inline __m512  load_masked(const __m512* a, int n)  { return _mm512_maskz_loadu_ps(__mmask16((1u << n) - 1), a); }
+		inline __m512d load_masked(const __m512d* a, int n) { return _mm512_maskz_loadu_pd(__mmask8((1u << n) - 1), a); }
+		inline __m512i load_masked(const __m512i* a, int n) { return _mm512_maskz_loadu_epi32(__mmask16((1u << n) - 1), a); }
+
+		inline void store_masked(__m512*  a, const __m512& v, int n)  { _mm512_mask_storeu_ps(a, __mmask16((1u << n) - 1), v); }
+		inline void store_masked(__m512d* a, const __m512d& v, int n) { _mm512_mask_storeu_pd(a, __mmask8((1u << n) - 1), v); }
+		inline void store_masked(__m512i* a, const __m512i& v, int n) { _mm512_mask_storeu_epi32(a, __mmask16((1u << n) - 1), v); }
+
+		// inclusive prefix sum across the lanes of one register: log2(lanes) steps of shift-in-zeros and add
+		inline __m512 scan_lanes(__m512 x)
+		{
+			const __m512i z = _mm512_setzero_si512();
+			x = _mm512_add_ps(x, _mm512_castsi512_ps(_mm512_alignr_epi32(_mm512_castps_si512(x), z, 15)));
+			x = _mm512_add_ps(x, _mm512_castsi512_ps(_mm512_alignr_epi32(_mm512_castps_si512(x), z, 14)));
+			x = _mm512_add_ps(x, _mm512_castsi512_ps(_mm512_alignr_epi32(_mm512_castps_si512(x), z, 12)));
+			return _mm512_add_ps(x, _mm512_castsi512_ps(_mm512_alignr_epi32(_mm512_castps_si512(x), z, 8)));
+		}
+
+		inline __m512d scan_lanes(__m512d x)
+		{
+			const __m512i z = _mm512_setzero_si512();
+			x = _mm512_add_pd(x, _mm512_castsi512_pd(_mm512_alignr_epi64(_mm512_castpd_si512(x), z, 7)));
+			x = _mm512_add_pd(x, _mm512_castsi512_pd(_mm512_alignr_epi64(_mm512_castpd_si512(x), z, 6)));
+			return _mm512_add_pd(x, _mm512_castsi512_pd(_mm512_alignr_epi64(_mm512_castpd_si512(x), z, 4)));
+		}
+
+		inline __m512i scan_lanes(__m512i x)
+		{
+			const __m512i z = _mm512_setzero_si512();
+			x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, z, 15));
+			x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, z, 14));
+			x = _mm512_add_epi32(x, _mm512_alignr_epi32(x, z, 12));
+			return _mm512_add_epi32(x, _mm512_alignr_epi32(x, z, 8));
+		}
+
+		// x moved up by one lane, lane 0 taken from the top lane of c
+		inline __m512  shift_in(__m512 x, __m512 c)   { return _mm512_castsi512_ps(_mm512_alignr_epi32(_mm512_castps_si512(x), _mm512_castps_si512(c), 15)); }
+		inline __m512d shift_in(__m512d x, __m512d c) { return _mm512_castsi512_pd(_mm512_alignr_epi64(_mm512_castpd_si512(x), _mm512_castpd_si512(c), 7)); }
+		inline __m512i shift_in(__m512i x, __m512i c) { return _mm512_alignr_epi32(x, c, 15); }
+
+		inline __m512  broadcast_last(__m512 x)  { return _mm512_permutexvar_ps(_mm512_set1_epi32(15), x); }
+		inline __m512d broadcast_last(__m512d x) { return _mm512_permutexvar_pd(_mm512_set1_epi64(7), x); }
+		inline __m512i broadcast_last(__m512i x) { return _mm512_permutexvar_epi32(_mm512_set1_epi32(15), x); }
+
+		inline float   first_lane(__m512 x)  { return _mm512_cvtss_f32(x); }
+		inline double  first_lane(__m512d x) { return _mm512_cvtsd_f64(x); }
+		inline int     first_lane(__m512i x) { return _mm_cvtsi128_si32(_mm512_castsi512_si128(x)); }
+
+		// outputs of at least this many bytes are written around the cache by apply/zip/zips,
+		// set it to SIZE_MAX to always keep results cached
+		inline size_t stream_threshold = size_t(32) << 20;
+
+		struct cached_access
+		{
+			template<class V> static V load(const V* a) { return avx512::load(a); }
+			template<class V> static void store(V* a, const V& v) { avx512::store(a, v); }
+			static void fence() {}
+		};
+
+		// non-temporal stores skip the read-for-ownership, needs every pointer 64-byte aligned
+		struct streaming_access
+		{
+			template<class V> static V load(const V* a) { return avx512::load_aligned(a); }
+			template<class V> static void store(V* a, const V& v) { avx512::stream(a, v); }
+			static void fence() { _mm_sfence(); }
+		};
+
+		inline bool aligned(const void* p) { return (reinterpret_cast<uintptr_t>(p) & 63) == 0; }
+
 
 		struct exp2
 		{
@@ -156,52 +246,234 @@ namespace simd
 
 	template<class Derived, class Scalar, int Size> class ValArrayAVX512_Unrolled
 	{
+		using V = typename avx512::Value<Scalar>::Type;
+
+		template<class Access, class F, size_t... I>
+		static void apply_loop(V* i1, V* ie, const F& func, std::index_sequence<I...>)
+		{
+			constexpr std::ptrdiff_t U = sizeof...(I);
+			for (; ie - i1 >= U; i1 += U)
+			{
+				(Access::store(i1 + I, func(Access::load(i1 + I))), ...);
+			}
+			for (; i1 < ie; ++i1)
+			{
+				Access::store(i1, func(Access::load(i1)));
+			}
+			Access::fence();
+		}
+
+		template<class Access, class F, size_t... I>
+		static void zip_loop(V* i1, const V* i2, V* ie, const F& func, std::index_sequence<I...>)
+		{
+			constexpr std::ptrdiff_t U = sizeof...(I);
+			for (; ie - i1 >= U; i1 += U, i2 += U)
+			{
+				(Access::store(i1 + I, func(Access::load(i1 + I), Access::load(i2 + I))), ...);
+			}
+			for (; i1 < ie; ++i1, ++i2)
+			{
+				Access::store(i1, func(Access::load(i1), Access::load(i2)));
+			}
+			Access::fence();
+		}
+
+		template<class Access, class F, size_t... I>
+		static void zips_loop(V* i1, V* ie, const V& v, const F& func, std::index_sequence<I...>)
+		{
+			constexpr std::ptrdiff_t U = sizeof...(I);
+			for (; ie - i1 >= U; i1 += U)
+			{
+				(Access::store(i1 + I, func(Access::load(i1 + I), v)), ...);
+			}
+			for (; i1 < ie; ++i1)
+			{
+				Access::store(i1, func(Access::load(i1), v));
+			}
+			Access::fence();
+		}
+
+		// calls loop(std::index_sequence<0..avx512::unroll-1>)
+		template<class Loop>
+		static void unrolled(const Loop& loop)
+		{
+			switch (avx512::unroll)
+			{
+			case 1:  loop(std::make_index_sequence<1>{}); break;
+			case 2:  loop(std::make_index_sequence<2>{}); break;
+			case 8:  loop(std::make_index_sequence<8>{}); break;
+			default: loop(std::make_index_sequence<4>{}); break;
+			}
+		}
+
+		static const int L = int(sizeof(V) / sizeof(Scalar));
+
+		// [begin, end) as a masked head up to the first 64-byte boundary, whole registers [body, body_end)
+		// and a masked tail. Owning arrays are aligned whole registers, head == tail == 0; views need not be.
+		struct Span
+		{
+			int head;
+			V*  body;
+			V*  body_end;
+			int tail;
+		};
+
+		Span span()
+		{
+			Scalar* b = ((Derived*)(this))->begin();
+			const int n = int(((Derived*)(this))->end() - b);
+			const uintptr_t a = reinterpret_cast<uintptr_t>(b);
+			const int head = (a % sizeof(Scalar)) ? 0 : std::min(n, int(((64 - (a & 63)) & 63) / sizeof(Scalar)));
+			const int whole = (n - head) / L;
+			V* body = reinterpret_cast<V*>(b + head);
+			return { head, body, body + whole, n - head - whole*L };
+		}
+
+		// rhs's register at the same element offset as lhs's register p
+		const V* along(const Derived& rhs, const V* p)
+		{
+			return reinterpret_cast<const V*>(rhs.begin() + (reinterpret_cast<const Scalar*>(p) - ((Derived*)(this))->begin()));
+		}
+
+		V* head_of() { return reinterpret_cast<V*>(((Derived*)(this))->begin()); }
+
+		template<class F> static void masked(V* p, int n, const F& func)
+		{
+			if (n)
+				avx512::store_masked(p, func(avx512::load_masked(p, n)), n);
+		}
+
+		template<class F> static void masked(V* p, const V* q, int n, const F& func)
+		{
+			if (n)
+				avx512::store_masked(p, func(avx512::load_masked(p, n), avx512::load_masked(q, n)), n);
+		}
+
+		bool large() { return size_t(reinterpret_cast<char*>(((Derived*)(this))->end()) - reinterpret_cast<char*>(((Derived*)(this))->begin())) >= avx512::stream_threshold; }
 	public:
-		template<class F>
-		Derived& apply(const F& func)
+		// Running sum in place, every element also gets carry added. Returns carry plus the total of the array,
+		// the carry for whatever follows, so scans chain across arrays (see Step_Scan).
+		Scalar inclusive_scan(Scalar carry = Scalar{})
+		{
+			V c = avx512::Value<Scalar>::fill(carry);
+			Scalar* b = ((Derived*)(this))->begin();
+			const int n = int(((Derived*)(this))->end() - b);
+			int i = 0;
+			for (; i + L <= n; i += L)
+			{
+				V* p = reinterpret_cast<V*>(b + i);
+				const V x = avx512::plus{}(avx512::scan_lanes(avx512::load(p)), c);
+				avx512::store(p, x);
+				c = avx512::broadcast_last(x);
+			}
+			Scalar s = avx512::first_lane(c);
+			for (; i < n; ++i)
+				b[i] = (s += b[i]);
+			return s;
+		}
+
+		// as inclusive_scan, but every element becomes carry plus the sum of the elements before it
+		Scalar exclusive_scan(Scalar carry = Scalar{})
 		{
-			auto i1 = reinterpret_cast<typename avx512::Value<Scalar>::Type*>(((Derived*)(this))->begin());
-			auto ie = reinterpret_cast<typename avx512::Value<Scalar>::Type*>(((Derived*)(this))->end());
-			for (; i1 != ie; i1 += 4)
+			V c = avx512::Value<Scalar>::fill(carry);
+			Scalar* b = ((Derived*)(this))->begin();
+			const int n = int(((Derived*)(this))->end() - b);
+			int i = 0;
+			for (; i + L <= n; i += L)
 			{
-				avx512::store(i1 + 0, func(avx512::load(i1 + 0)));
-				avx512::store(i1 + 1, func(avx512::load(i1 + 1)));
-				avx512::store(i1 + 2, func(avx512::load(i1 + 2)));
-				avx512::store(i1 + 3, func(avx512::load(i1 + 3)));
+				V* p = reinterpret_cast<V*>(b + i);
+				const V x = avx512::plus{}(avx512::scan_lanes(avx512::load(p)), c);
+				avx512::store(p, avx512::shift_in(x, c));
+				c = avx512::broadcast_last(x);
 			}
+			Scalar s = avx512::first_lane(c);
+			for (; i < n; ++i)
+			{
+				const Scalar x = b[i];
+				b[i] = s;
+				s += x;
+			}
+			return s;
+		}
+
+		template<class F>
+		Derived& apply(const F& func)
+		{
+			if (large())
+				return apply_stream(func);
+			const Span s = span();
+			masked(head_of(), s.head, func);
+			unrolled([&](auto u) { apply_loop<avx512::cached_access>(s.body, s.body_end, func, u); });
+			masked(s.body_end, s.tail, func);
 			return *((Derived*)this);
 		}
 
 		template<class F>
 		Derived& zip(const Derived& rhs, const F& func)
 		{
-			auto i1 = reinterpret_cast<typename avx512::Value<Scalar>::Type*>(((Derived*)(this))->begin());
-			auto i2 = reinterpret_cast<const typename avx512::Value<Scalar>::Type*>(rhs.begin());
-			auto ie = reinterpret_cast<typename avx512::Value<Scalar>::Type*>(((Derived*)(this))->end());
-			for (; i1 != ie; i1 += 4, i2 += 4)
-			{
-				avx512::store(i1 + 0, func(avx512::load(i1 + 0), avx512::load(i2 + 0)));
-				avx512::store(i1 + 1, func(avx512::load(i1 + 1), avx512::load(i2 + 1)));
-				avx512::store(i1 + 2, func(avx512::load(i1 + 2), avx512::load(i2 + 2)));
-				avx512::store(i1 + 3, func(avx512::load(i1 + 3), avx512::load(i2 + 3)));
-			}
+			if (large())
+				return zip_stream(rhs, func);
+			const Span s = span();
+			masked(head_of(), along(rhs, head_of()), s.head, func);
+			unrolled([&](auto u) { zip_loop<avx512::cached_access>(s.body, along(rhs, s.body), s.body_end, func, u); });
+			masked(s.body_end, along(rhs, s.body_end), s.tail, func);
 			return *((Derived*)this);
 		}
 
 		template<class F>
 		Derived& zips(const Scalar& rhs, const F& func)
 		{
-			auto i1 = reinterpret_cast<typename avx512::Value<Scalar>::Type*>(((Derived*)(this))->begin());
-			auto ie = reinterpret_cast<typename avx512::Value<Scalar>::Type*>(((Derived*)(this))->end());
-			auto v = avx512::Value<Scalar>::fill(rhs);
+			if (large())
+				return zips_stream(rhs, func);
+			const Span s = span();
+			const V v = avx512::Value<Scalar>::fill(rhs);
+			const auto with = [&](const V& x) { return func(x, v); };
+			masked(head_of(), s.head, with);
+			unrolled([&](auto u) { zips_loop<avx512::cached_access>(s.body, s.body_end, v, func, u); });
+			masked(s.body_end, s.tail, with);
+			return *((Derived*)this);
+		}
 
-			for (; i1 != ie; i1 +=4)
-			{
-				avx512::store(i1 + 0, func(avx512::load(i1 + 0), v));
-				avx512::store(i1 + 1, func(avx512::load(i1 + 1), v));
-				avx512::store(i1 + 2, func(avx512::load(i1 + 2), v));
-				avx512::store(i1 + 3, func(avx512::load(i1 + 3), v));
-			}
+		// same as apply/zip/zips, but results bypass the cache regardless of size
+		template<class F>
+		Derived& apply_stream(const F& func)
+		{
+			const Span s = span();
+			masked(head_of(), s.head, func);
+			if (avx512::aligned(s.body))
+				unrolled([&](auto u) { apply_loop<avx512::streaming_access>(s.body, s.body_end, func, u); });
+			else
+				unrolled([&](auto u) { apply_loop<avx512::cached_access>(s.body, s.body_end, func, u); });
+			masked(s.body_end, s.tail, func);
+			return *((Derived*)this);
+		}
+
+		template<class F>
+		Derived& zip_stream(const Derived& rhs, const F& func)
+		{
+			const Span s = span();
+			auto i2 = along(rhs, s.body);
+			masked(head_of(), along(rhs, head_of()), s.head, func);
+			if (avx512::aligned(s.body) && avx512::aligned(i2))
+				unrolled([&](auto u) { zip_loop<avx512::streaming_access>(s.body, i2, s.body_end, func, u); });
+			else
+				unrolled([&](auto u) { zip_loop<avx512::cached_access>(s.body, i2, s.body_end, func, u); });
+			masked(s.body_end, along(rhs, s.body_end), s.tail, func);
+			return *((Derived*)this);
+		}
+
+		template<class F>
+		Derived& zips_stream(const Scalar& rhs, const F& func)
+		{
+			const Span s = span();
+			const V v = avx512::Value<Scalar>::fill(rhs);
+			const auto with = [&](const V& x) { return func(x, v); };
+			masked(head_of(), s.head, with);
+			if (avx512::aligned(s.body))
+				unrolled([&](auto u) { zips_loop<avx512::streaming_access>(s.body, s.body_end, v, func, u); });
+			else
+				unrolled([&](auto u) { zips_loop<avx512::cached_access>(s.body, s.body_end, v, func, u); });
+			masked(s.body_end, s.tail, with);
 			return *((Derived*)this);
 		}
 	};
@@ -448,6 +720,7 @@ namespace simd
 	template<class Derived, class Scalar, int Z> class ValArrayAVX512 : public ValArrayAVX512_Unrolled<Derived, Scalar, Z*sizeof(Scalar)>
 	{
 	public:
+		// out-of-place operators copy through Derived::clone(), views give it their own storage
 		Derived clone() const { return Derived{*(reinterpret_cast<const Derived*>(this))}; }
 
 		__forceinline Derived& operator+=(const Derived& rhs) {	return this->zip(rhs, avx512::plus{});	}
@@ -463,26 +736,26 @@ namespace simd
 		__forceinline Derived& operator*=(const Scalar& rhs) { return this->zips(rhs, avx512::multiplies{}); }
 		__forceinline Derived& operator/=(const Scalar& rhs) { return this->zips(rhs, avx512::divides{}); }
 
-		__forceinline Derived operator+(const Derived& rhs) const { return clone() += rhs; }
-		__forceinline Derived operator-(const Derived& rhs) const { return clone() -= rhs; }
-		__forceinline Derived operator*(const Derived& rhs) const { return clone() *= rhs; }
-		__forceinline Derived operator/(const Derived& rhs) const { return clone() /= rhs; }
+		__forceinline Derived operator+(const Derived& rhs) const { return std::move(((const Derived*)this)->clone() += rhs); }
+		__forceinline Derived operator-(const Derived& rhs) const { return std::move(((const Derived*)this)->clone() -= rhs); }
+		__forceinline Derived operator*(const Derived& rhs) const { return std::move(((const Derived*)this)->clone() *= rhs); }
+		__forceinline Derived operator/(const Derived& rhs) const { return std::move(((const Derived*)this)->clone() /= rhs); }
 		
-		__forceinline Derived operator+(const Scalar& rhs) const { return clone() += rhs; }
-		__forceinline Derived operator-(const Scalar& rhs) const { return clone() -= rhs; }
-		__forceinline Derived operator*(const Scalar& rhs) const { return clone() *= rhs; }
-		__forceinline Derived operator/(const Scalar& rhs) const { return clone() /= rhs; }
-		__forceinline Derived& inverse(const Scalar& rhs) const { return clone().zips(rhs, avx512::divides_rev{}); }
+		__forceinline Derived operator+(const Scalar& rhs) const { return std::move(((const Derived*)this)->clone() += rhs); }
+		__forceinline Derived operator-(const Scalar& rhs) const { return std::move(((const Derived*)this)->clone() -= rhs); }
+		__forceinline Derived operator*(const Scalar& rhs) const { return std::move(((const Derived*)this)->clone() *= rhs); }
+		__forceinline Derived operator/(const Scalar& rhs) const { return std::move(((const Derived*)this)->clone() /= rhs); }
+		__forceinline Derived inverse(const Scalar& rhs) const { return std::move(((const Derived*)this)->clone().zips(rhs, avx512::divides_rev{})); }
 
 		friend Derived operator*(const Scalar& lhs, const Derived& rhs) { return rhs * lhs; }
 		friend Derived operator-(const Scalar& lhs, const Derived& rhs) { return -rhs + lhs; }
 		friend Derived operator+(const Scalar& lhs, const Derived& rhs) { return rhs + lhs; }
 		friend Derived operator/(const Scalar& lhs, const Derived& rhs) { return rhs.inverse(lhs); }
 		
-		friend Derived exp2(const Derived& x) { return x.clone().apply(avx512::exp2{}); }
-		friend Derived clip_positive(const Derived& x) { return x.clone().apply(avx512::clip_positive{}); }
-		friend Derived sign_positive(const Derived& x) { return x.clone().apply(avx512::sign_positive{}); }
-		friend Derived abs(const Derived& x) { return x.clone().apply(avx512::abs{}); }
+		friend Derived exp2(const Derived& x) { return std::move(x.clone().apply(avx512::exp2{})); }
+		friend Derived clip_positive(const Derived& x) { return std::move(x.clone().apply(avx512::clip_positive{})); }
+		friend Derived sign_positive(const Derived& x) { return std::move(x.clone().apply(avx512::sign_positive{})); }
+		friend Derived abs(const Derived& x) { return std::move(x.clone().apply(avx512::abs{})); }
 	};
 
 	template<class Scalar, int Z> class alignas(64) AlignedArrayAVX512 : public ValArrayAVX512<AlignedArrayAVX512<Scalar, Z>, Scalar, Z>
@@ -528,16 +801,123 @@ namespace simd
 
 	template<class Scalar> class AlignedVectorAVX512 : public ValArrayAVX512<AlignedVectorAVX512<Scalar>, Scalar, 0>
 	{
-		Scalar* data;
-		int Z;
+	public:
+		// Allocated: data came from resource and goes back to it
+		// Adopted:   resource only knows how to give [base, base+length) back (e.g. a file mapping)
+		// View:      memory belongs to someone else
+		enum class Storage { Allocated, Adopted, View };
+	private:
+		Scalar* data = nullptr;
+		int Z = 0;
+
+		void*   base = nullptr;
+		size_t  length = 0;
+		Storage storage = Storage::View;
+		std::pmr::memory_resource* resource = nullptr;
+
+		static size_t bytes_for(int sz) { return (sz*sizeof(Scalar) + 63) & ~size_t(63); }
+
+		void allocate(int sz, std::pmr::memory_resource* res)
+		{
+			Z = sz;
+			length = bytes_for(sz);
+			resource = res;
+			storage = Storage::Allocated;
+			base = resource->allocate(length, 64);
+			data = static_cast<Scalar*>(base);
+		}
+
+		void release()
+		{
+			if (storage != Storage::View)
+				resource->deallocate(base, length, 64);
+			data = nullptr;
+			base = nullptr;
+			Z = 0;
+			length = 0;
+			storage = Storage::View;
+		}
+
+		// copies of mapped or viewed vectors land in the default resource
+		std::pmr::memory_resource* copy_resource() const
+		{
+			return (storage == Storage::Allocated) ? resource : std::pmr::get_default_resource();
+		}
 	public:
 		using ScalarType = Scalar;
 
-		AlignedVectorAVX512(int sz) : Z(sz)
-		{  data = std::aligned_alloc(64, Z*sizeof(Scalar)); }
+		AlignedVectorAVX512(int sz, std::pmr::memory_resource* res = std::pmr::get_default_resource())
+		{
+			allocate(sz, res);
+		}
+
+		// adopts [mem, mem+sz) which lives inside [mem_base, mem_base+mem_length);
+		// with a resource the range is handed back to it on destruction, without one the vector is a view
+		AlignedVectorAVX512(Scalar* mem, int sz, void* mem_base = nullptr, size_t mem_length = 0, std::pmr::memory_resource* mem_resource = nullptr)
+			: data(mem), Z(sz), base(mem_base), length(mem_length),
+			  storage(mem_resource ? Storage::Adopted : Storage::View), resource(mem_resource)
+		{
+			// views run the masked-head kernels and may start anywhere, adopted memory stays whole aligned registers
+			if (mem_resource && reinterpret_cast<uintptr_t>(mem) % 64)
+				throw std::invalid_argument("AlignedVectorAVX512: adopted memory is not 64-byte aligned");
+		}
+
+		AlignedVectorAVX512(const AlignedVectorAVX512& rhs)
+		{
+			allocate(rhs.Z, rhs.copy_resource());
+			std::copy(rhs.begin(), rhs.end(), data);
+		}
+
+		AlignedVectorAVX512(AlignedVectorAVX512&& rhs) noexcept
+			: data(rhs.data), Z(rhs.Z), base(rhs.base), length(rhs.length), storage(rhs.storage), resource(rhs.resource)
+		{
+			rhs.data = nullptr;
+			rhs.base = nullptr;
+			rhs.Z = 0;
+			rhs.length = 0;
+			rhs.storage = Storage::View;
+		}
+
+		AlignedVectorAVX512& operator=(const AlignedVectorAVX512& rhs)
+		{
+			if (this == &rhs)
+				return *this;
+
+			// same size reuses the buffer, including mapped and viewed ones
+			if (Z != rhs.Z)
+			{
+				release();
+				allocate(rhs.Z, rhs.copy_resource());
+			}
+			std::copy(rhs.begin(), rhs.end(), data);
+			return *this;
+		}
+
+		AlignedVectorAVX512& operator=(AlignedVectorAVX512&& rhs) noexcept
+		{
+			if (this != &rhs)
+			{
+				release();
+				std::swap(data, rhs.data);
+				std::swap(Z, rhs.Z);
+				std::swap(base, rhs.base);
+				std::swap(length, rhs.length);
+				std::swap(storage, rhs.storage);
+				std::swap(resource, rhs.resource);
+			}
+			return *this;
+		}
+
+		AlignedVectorAVX512& operator=(const Scalar& rhs) { return ValArrayAVX512<AlignedVectorAVX512<Scalar>, Scalar, 0>::operator=(rhs); };
 
 		~AlignedVectorAVX512()
-		{ std::free(data); }
+		{
+			release();
+		}
+
+		bool owns_memory() const { return storage != Storage::View; }
+		int size() const { return Z; }
+		std::pmr::memory_resource* memory_resource() const { return resource; }
 
 		const Scalar* begin() const
 		{
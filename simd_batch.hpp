@@ -0,0 +1,238 @@
+#pragma once
+#include "simd.hpp"
+#include "simd_array.hpp"
+
+#include <memory_resource>
+#include <vector>
+#include <atomic>
+#include <utility>
+#include <type_traits>
+#include <algorithm>
+
+namespace simd
+{
+	namespace cpu
+	{
+		// Many independent problems of Z elements each, the same Algorithm as a Dispatcher would run.
+		// A problem never leaves the thread that picked it up: its Z/RO instances and its Accumulator are built in
+		// that thread's scratch space, all of its steps run there in order, and Fold/Scan/Vote steps reduce over the
+		// problem's own instances in batch order. No barrier or atomic is crossed inside a problem, so throughput
+		// scales with threads as long as there are more problems than threads.
+		// Shared state is per problem (Shared(i)) and persists across Run()s, like Dispatcher::Shared().
+		// Runs on any pool with Parallel(job) and threads, e.g. a Dispatcher.
+		template<template<class DataBatch> typename Algorithm, int Z, class Scalar,
+			template<class DataBatch> typename AlgorithmPrimary = Algorithm, int RO = 64,
+			template<typename, int> typename SIMDArray = AlignedArray> class BatchDispatcher
+		{
+			static_assert(Z % RO == 0 && Z >= 2*RO, "a problem is a whole number of RO-element batches, at least two");
+
+			using ThreadBatch = typename SIMDArray<Scalar, RO>;
+			using SharedData  = typename Algorithm<ThreadBatch>::Shared;
+			using Accumulator = typename Algorithm<ThreadBatch>::Accumulator;
+			using Steps = std::make_index_sequence<Algorithm<ThreadBatch>::MaxStep + 1>;
+
+			static const int P = Z / RO;
+
+			// one problem's instances, batch 0 is the primary as on the Dispatcher's master thread
+			struct ProblemSet
+			{
+				AlgorithmPrimary<ThreadBatch> alg_master;
+				Algorithm<ThreadBatch> alg[P - 1];
+				Accumulator acc;
+			};
+
+			std::pmr::memory_resource* mResource;
+			std::pmr::vector<SharedData> mShared;
+			std::vector<void*> mScratch;
+			std::atomic<int> mNext{ 0 };
+
+			template<int STEP, class Kind, class = void> struct callable : std::false_type {};
+			template<int STEP, class Kind> struct callable<STEP, Kind, std::void_t<decltype(std::declval<Algorithm<ThreadBatch>&>()(StepTag<STEP, Kind>{}))>> : std::true_type {};
+
+			template<class F> static void ForEachInstance(ProblemSet* set, const F& f)
+			{
+				f(set->alg_master);
+				for (auto& instance : set->alg)
+					f(instance);
+			}
+
+			template<int STEP> static int RunParallel(ProblemSet* set)
+			{
+				using ret_type = decltype(std::declval<Algorithm<ThreadBatch>&>()(StepTag<STEP, Step_Parallel>{}));
+				if constexpr (is_vote<ret_type>::value)
+				{
+					// every vote is in right away, no need to wait a round
+					const Vote first = set->alg_master(StepTag<STEP, Step_Parallel>{});
+					bool done = first.done;
+					for (auto& instance : set->alg)
+						done = instance(StepTag<STEP, Step_Parallel>{}).done && done;
+					return done ? first.exit_step : first.next_step;
+				}
+				else if constexpr (is_fold<ret_type>::value || is_fold_async<ret_type>::value)
+				{
+					using Op = typename ret_type::Monoid;
+					ret_type res = set->alg_master(StepTag<STEP, Step_Parallel>{});
+					for (auto& instance : set->alg)
+					{
+						Op::combine(*(res.merge_source), *(instance(StepTag<STEP, Step_Parallel>{}).merge_source));
+					}
+					Op::finish(*(res.merge_source), *(res.merge_target));
+					if constexpr (is_fold_async<ret_type>::value)
+					{
+						if (res.future)
+							res.future->arm(res.merge_target);
+					}
+					return res.next_step;
+				}
+				else if constexpr (is_fold_acc<ret_type>::value)
+				{
+					using Op = typename ret_type::Monoid;
+					ret_type res = set->alg_master(StepTag<STEP, Step_Parallel>{});
+					for (auto& instance : set->alg)
+						instance(StepTag<STEP, Step_Parallel>{});
+					Op::finish(*(res.merge_source), *(res.merge_target));
+					return res.next_step;
+				}
+				else if constexpr (std::is_base_of<FoldMultiTag, ret_type>::value)
+				{
+					using Op = typename ret_type::Monoid;
+					ret_type res = set->alg_master(StepTag<STEP, Step_Parallel>{});
+					for (auto& instance : set->alg)
+						instance(StepTag<STEP, Step_Parallel>{});
+					traverse_accums(res.merge_target, res.merge_source, [](auto& lhs, const auto& rhs) { Op::finish(rhs, lhs); });
+					return res.next_step;
+				}
+				else
+				{
+					for (auto& instance : set->alg)
+						instance(StepTag<STEP, Step_Parallel>{});
+					return set->alg_master(StepTag<STEP, Step_Parallel>{});
+				}
+			}
+
+			template<int STEP> static int RunStep(ProblemSet* set)
+			{
+				if constexpr (callable<STEP, Step_Parallel>::value)
+				{
+					return RunParallel<STEP>(set);
+				}
+				else if constexpr (callable<STEP, Step_Separate>::value)
+				{
+					int res = 0;
+					for (int j = 0; j < RO; ++j)
+						res = set->alg_master(StepTag<STEP, Step_Separate>{ j, j });
+					for (int i = 0; i < P - 1; ++i)
+					{
+						for (int j = 0; j < RO; ++j)
+							set->alg[i](StepTag<STEP, Step_Separate>{ (i + 1)*RO + j, j });
+					}
+					return res;
+				}
+				else if constexpr (callable<STEP, Step_Singlethreaded>::value)
+				{
+					return set->alg_master(StepTag<STEP, Step_Singlethreaded>{});
+				}
+				else if constexpr (callable<STEP, Step_Accumulate>::value)
+				{
+					int res = set->alg_master(StepTag<STEP, Step_Accumulate>{});
+					for (auto& instance : set->alg)
+						res = instance(StepTag<STEP, Step_Accumulate>{});
+					return res;
+				}
+				else if constexpr (callable<STEP, Step_AccReset>::value)
+				{
+					return set->alg_master(StepTag<STEP, Step_AccReset>{});
+				}
+				else if constexpr (callable<STEP, Step_Scan>::value)
+				{
+					// exclusive scan of the totals in batch order
+					using ret_type = decltype(std::declval<Algorithm<ThreadBatch>&>()(StepTag<STEP, Step_Scan>{}));
+					using Op = typename ret_type::Monoid;
+					using S = std::remove_pointer_t<decltype(ret_type::carry)>;
+					S c = Op::template identity<S>();
+					int next = -1;
+					ForEachInstance(set, [&](auto& instance)
+					{
+						ret_type part = instance(StepTag<STEP, Step_Scan>{});
+						*part.carry = c;
+						Op::combine(c, *part.total);
+						if (next < 0)
+							next = part.next_step;
+					});
+					return next;
+				}
+				else
+				{
+					return -1;
+				}
+			}
+
+			template<size_t... S> static int RunStepAt(int step, ProblemSet* set, std::index_sequence<S...>)
+			{
+				int next = -1;
+				(void)((step == int(S) && (next = RunStep<int(S)>(set), true)) || ...);
+				return next;
+			}
+
+			void Solve(int i, void* scratch)
+			{
+				auto set = new (scratch) ProblemSet();
+				set->alg_master.init(&mShared[i], &set->acc);
+				for (auto& a : set->alg)
+					a.init(&mShared[i], &set->acc);
+
+				int step = 0;
+				while (step >= 0)
+				{
+					step = RunStepAt(step, set, Steps{});
+				}
+
+				set->~ProblemSet();
+			}
+
+			void Reserve(int threads)
+			{
+				while (int(mScratch.size()) < threads)
+					mScratch.push_back(mResource->allocate(sizeof(ProblemSet), std::max<size_t>(alignof(ProblemSet), 64)));
+			}
+
+		public:
+			explicit BatchDispatcher(int problems, std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+				: mResource(resource), mShared(problems, resource)
+			{
+			}
+
+			BatchDispatcher(const BatchDispatcher&) = delete;
+			BatchDispatcher& operator=(const BatchDispatcher&) = delete;
+
+			~BatchDispatcher()
+			{
+				for (void* p : mScratch)
+					mResource->deallocate(p, sizeof(ProblemSet), std::max<size_t>(alignof(ProblemSet), 64));
+			}
+
+			int size() const { return int(mShared.size()); }
+
+			SharedData& Shared(int i) { return mShared[i]; }
+
+			// runs problem i to completion on the calling thread
+			void Run(int i)
+			{
+				Reserve(1);
+				Solve(i, mScratch[0]);
+			}
+
+			// runs every problem once, handed out one at a time to the pool's threads
+			template<class Pool> void Run(Pool& pool)
+			{
+				Reserve(Pool::threads);
+				mNext.store(0, std::memory_order_relaxed);
+				pool.Parallel([this](int t)
+				{
+					for (int i = mNext.fetch_add(1, std::memory_order_relaxed); i < size(); i = mNext.fetch_add(1, std::memory_order_relaxed))
+						Solve(i, mScratch[t]);
+				});
+			}
+		};
+	}
+}
@@ -0,0 +1,332 @@
+#pragma once
+#include "simd_array_avx512.hpp"
+
+#include <immintrin.h>
+#include <complex>
+#include <algorithm>
+
+namespace simd
+{
+	namespace detail
+	{
+		// Interleaved complex numbers, re/im in even/odd lanes: L complex values per register
+		template<class T> struct ComplexOps {};
+
+		template<> struct ComplexOps<float>
+		{
+			using V = __m512;
+			static const int L = 8;
+
+			static V load(const std::complex<float>* p)           { return _mm512_loadu_ps(p); }
+			static void store(std::complex<float>* p, V v)        { _mm512_storeu_ps(p, v); }
+			static V load(const std::complex<float>* p, int n)    { return _mm512_maskz_loadu_ps(__mmask16((1u << 2*n) - 1), p); }
+			static void store(std::complex<float>* p, V v, int n) { _mm512_mask_storeu_ps(p, __mmask16((1u << 2*n) - 1), v); }
+			static V fill(std::complex<float> c)                  { return _mm512_mask_blend_ps(0xAAAA, _mm512_set1_ps(c.real()), _mm512_set1_ps(c.imag())); }
+			static V fill(float x)                                { return _mm512_set1_ps(x); }
+
+			static V add(V a, V b) { return _mm512_add_ps(a, b); }
+			static V sub(V a, V b) { return _mm512_sub_ps(a, b); }
+			static V scale(V a, V b) { return _mm512_mul_ps(a, b); }
+			static V re(V a)   { return _mm512_moveldup_ps(a); }
+			static V im(V a)   { return _mm512_movehdup_ps(a); }
+			static V swap(V a) { return _mm512_permute_ps(a, 0xB1); }
+			static V neg_odd(V a)  { return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), _mm512_set1_epi64(int64_t(0x8000000000000000ull)))); }
+			static V neg_even(V a) { return _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(a), _mm512_set1_epi64(0x80000000ll))); }
+			// a*re(b) -/+ swap(a)*im(b): (ar br - ai bi, ai br + ar bi)
+			static V mul(V a, V b) { return _mm512_fmaddsub_ps(a, re(b), _mm512_mul_ps(swap(a), im(b))); }
+			// a*conj(b): (ar br + ai bi, ai br - ar bi)
+			static V mul_conj(V a, V b) { return _mm512_fmsubadd_ps(a, re(b), _mm512_mul_ps(swap(a), im(b))); }
+			// |z|^2 in both lanes of z
+			static V norm2(V a) { const V s = _mm512_mul_ps(a, a); return _mm512_add_ps(s, swap(s)); }
+			static V sqrt(V a) { return _mm512_sqrt_ps(a); }
+
+			// a, b hold 2L interleaved values <-> r, i hold their 2L real and imaginary parts
+			static void split(V a, V b, V& r, V& i)
+			{
+				r = _mm512_permutex2var_ps(a, _mm512_setr_epi32(0, 2, 4, 6, 8, 10, 12, 14, 16, 18, 20, 22, 24, 26, 28, 30), b);
+				i = _mm512_permutex2var_ps(a, _mm512_setr_epi32(1, 3, 5, 7, 9, 11, 13, 15, 17, 19, 21, 23, 25, 27, 29, 31), b);
+			}
+			static void interleave(V r, V i, V& a, V& b)
+			{
+				a = _mm512_permutex2var_ps(r, _mm512_setr_epi32(0, 16, 1, 17, 2, 18, 3, 19, 4, 20, 5, 21, 6, 22, 7, 23), i);
+				b = _mm512_permutex2var_ps(r, _mm512_setr_epi32(8, 24, 9, 25, 10, 26, 11, 27, 12, 28, 13, 29, 14, 30, 15, 31), i);
+			}
+			static V load_real(const float* p)        { return _mm512_loadu_ps(p); }
+			static void store_real(float* p, V v)     { _mm512_storeu_ps(p, v); }
+		};
+
+		template<> struct ComplexOps<double>
+		{
+			using V = __m512d;
+			static const int L = 4;
+
+			static V load(const std::complex<double>* p)           { return _mm512_loadu_pd(p); }
+			static void store(std::complex<double>* p, V v)        { _mm512_storeu_pd(p, v); }
+			static V load(const std::complex<double>* p, int n)    { return _mm512_maskz_loadu_pd(__mmask8((1u << 2*n) - 1), p); }
+			static void store(std::complex<double>* p, V v, int n) { _mm512_mask_storeu_pd(p, __mmask8((1u << 2*n) - 1), v); }
+			static V fill(std::complex<double> c)                  { return _mm512_mask_blend_pd(0xAA, _mm512_set1_pd(c.real()), _mm512_set1_pd(c.imag())); }
+			static V fill(double x)                                { return _mm512_set1_pd(x); }
+
+			static V add(V a, V b) { return _mm512_add_pd(a, b); }
+			static V sub(V a, V b) { return _mm512_sub_pd(a, b); }
+			static V scale(V a, V b) { return _mm512_mul_pd(a, b); }
+			static V re(V a)   { return _mm512_movedup_pd(a); }
+			static V im(V a)   { return _mm512_permute_pd(a, 0xFF); }
+			static V swap(V a) { return _mm512_permute_pd(a, 0x55); }
+			static V neg_odd(V a)  { return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a), _mm512_setr_epi64(0, int64_t(0x8000000000000000ull), 0, int64_t(0x8000000000000000ull), 0, int64_t(0x8000000000000000ull), 0, int64_t(0x8000000000000000ull)))); }
+			static V neg_even(V a) { return _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(a), _mm512_setr_epi64(int64_t(0x8000000000000000ull), 0, int64_t(0x8000000000000000ull), 0, int64_t(0x8000000000000000ull), 0, int64_t(0x8000000000000000ull), 0))); }
+			static V mul(V a, V b) { return _mm512_fmaddsub_pd(a, re(b), _mm512_mul_pd(swap(a), im(b))); }
+			static V mul_conj(V a, V b) { return _mm512_fmsubadd_pd(a, re(b), _mm512_mul_pd(swap(a), im(b))); }
+			static V norm2(V a) { const V s = _mm512_mul_pd(a, a); return _mm512_add_pd(s, swap(s)); }
+			static V sqrt(V a) { return _mm512_sqrt_pd(a); }
+
+			static void split(V a, V b, V& r, V& i)
+			{
+				r = _mm512_permutex2var_pd(a, _mm512_setr_epi64(0, 2, 4, 6, 8, 10, 12, 14), b);
+				i = _mm512_permutex2var_pd(a, _mm512_setr_epi64(1, 3, 5, 7, 9, 11, 13, 15), b);
+			}
+			static void interleave(V r, V i, V& a, V& b)
+			{
+				a = _mm512_permutex2var_pd(r, _mm512_setr_epi64(0, 8, 1, 9, 2, 10, 3, 11), i);
+				b = _mm512_permutex2var_pd(r, _mm512_setr_epi64(4, 12, 5, 13, 6, 14, 7, 15), i);
+			}
+			static V load_real(const double* p)       { return _mm512_loadu_pd(p); }
+			static void store_real(double* p, V v)    { _mm512_storeu_pd(p, v); }
+		};
+
+		// f(v) for every register of [p, p + n), the last one masked
+		template<class T, class F> void complex_apply(std::complex<T>* p, int n, const F& f)
+		{
+			using Ops = ComplexOps<T>;
+			int i = 0;
+			for (; i + Ops::L <= n; i += Ops::L)
+				Ops::store(p + i, f(Ops::load(p + i)));
+			if (i < n)
+				Ops::store(p + i, f(Ops::load(p + i, n - i)), n - i);
+		}
+
+		template<class T, class F> void complex_zip(std::complex<T>* p, const std::complex<T>* q, int n, const F& f)
+		{
+			using Ops = ComplexOps<T>;
+			int i = 0;
+			for (; i + Ops::L <= n; i += Ops::L)
+				Ops::store(p + i, f(Ops::load(p + i), Ops::load(q + i)));
+			if (i < n)
+				Ops::store(p + i, f(Ops::load(p + i, n - i), Ops::load(q + i, n - i)), n - i);
+		}
+	}
+
+	// Element-wise complex arithmetic over the begin()/end() of Derived, interleaved std::complex<T> storage.
+	// The counterpart of ValArrayAVX512 for complex elements, see AlignedArrayAVX512<std::complex<T>, Z>.
+	template<class Derived, class T> class ComplexArrayAVX512
+	{
+		using Ops = detail::ComplexOps<T>;
+		using V = typename Ops::V;
+
+		std::complex<T>* first() { return ((Derived*)(this))->begin(); }
+		const std::complex<T>* first() const { return ((const Derived*)(this))->begin(); }
+		int count() const { return int(((const Derived*)(this))->end() - ((const Derived*)(this))->begin()); }
+	public:
+		template<class F> Derived& apply(const F& func)
+		{
+			detail::complex_apply(first(), count(), func);
+			return *((Derived*)this);
+		}
+
+		template<class F> Derived& zip(const Derived& rhs, const F& func)
+		{
+			detail::complex_zip(first(), rhs.begin(), count(), func);
+			return *((Derived*)this);
+		}
+
+		Derived& operator+=(const Derived& rhs) { return zip(rhs, [](V a, V b) { return Ops::add(a, b); }); }
+		Derived& operator-=(const Derived& rhs) { return zip(rhs, [](V a, V b) { return Ops::sub(a, b); }); }
+		Derived& operator*=(const Derived& rhs) { return zip(rhs, [](V a, V b) { return Ops::mul(a, b); }); }
+
+		// *this *= conj(rhs), the correlation product
+		Derived& mul_conj(const Derived& rhs) { return zip(rhs, [](V a, V b) { return Ops::mul_conj(a, b); }); }
+
+		Derived& operator+=(const std::complex<T>& rhs) { const V c = Ops::fill(rhs); return apply([c](V a) { return Ops::add(a, c); }); }
+		Derived& operator-=(const std::complex<T>& rhs) { const V c = Ops::fill(rhs); return apply([c](V a) { return Ops::sub(a, c); }); }
+		Derived& operator*=(const std::complex<T>& rhs) { const V c = Ops::fill(rhs); return apply([c](V a) { return Ops::mul(a, c); }); }
+		Derived& operator*=(const T& rhs) { const V c = Ops::fill(rhs); return apply([c](V a) { return Ops::scale(a, c); }); }
+
+		Derived& operator=(const std::complex<T>& rhs) { const V c = Ops::fill(rhs); return apply([c](V) { return c; }); }
+
+		// in place
+		Derived& conjugate() { return apply([](V a) { return Ops::neg_odd(a); }); }
+
+		// out[i] = |x[i]|^2, or |x[i]| for abs; out holds count() scalars
+		void norm(T* out) const { magnitudes<false>(out); }
+		void abs(T* out) const { magnitudes<true>(out); }
+
+		// split layout: re[i], im[i] <-> x[i]
+		void to_split(T* re, T* im) const
+		{
+			const std::complex<T>* p = first();
+			const int n = count();
+			int i = 0;
+			for (; i + 2*Ops::L <= n; i += 2*Ops::L)
+			{
+				V r, m;
+				Ops::split(Ops::load(p + i), Ops::load(p + i + Ops::L), r, m);
+				Ops::store_real(re + i, r);
+				Ops::store_real(im + i, m);
+			}
+			for (; i < n; ++i)
+			{
+				re[i] = p[i].real();
+				im[i] = p[i].imag();
+			}
+		}
+
+		Derived& from_split(const T* re, const T* im)
+		{
+			std::complex<T>* p = first();
+			const int n = count();
+			int i = 0;
+			for (; i + 2*Ops::L <= n; i += 2*Ops::L)
+			{
+				V a, b;
+				Ops::interleave(Ops::load_real(re + i), Ops::load_real(im + i), a, b);
+				Ops::store(p + i, a);
+				Ops::store(p + i + Ops::L, b);
+			}
+			for (; i < n; ++i)
+				p[i] = std::complex<T>(re[i], im[i]);
+			return *((Derived*)this);
+		}
+
+		std::complex<T> fold() const
+		{
+			const std::complex<T>* p = first();
+			const int n = count();
+			V acc = Ops::fill(T(0));
+			int i = 0;
+			for (; i + Ops::L <= n; i += Ops::L)
+				acc = Ops::add(acc, Ops::load(p + i));
+			if (i < n)
+				acc = Ops::add(acc, Ops::load(p + i, n - i));
+			alignas(64) std::complex<T> lanes[Ops::L];
+			Ops::store(lanes, acc);
+			std::complex<T> res{};
+			for (const auto& x : lanes) res += x;
+			return res;
+		}
+
+	private:
+		template<bool ROOT> void magnitudes(T* out) const
+		{
+			const std::complex<T>* p = first();
+			const int n = count();
+			int i = 0;
+			for (; i + 2*Ops::L <= n; i += 2*Ops::L)
+			{
+				V r, dup;
+				// norm2 leaves |z|^2 in both lanes, split keeps one copy of each
+				Ops::split(Ops::norm2(Ops::load(p + i)), Ops::norm2(Ops::load(p + i + Ops::L)), r, dup);
+				Ops::store_real(out + i, ROOT ? Ops::sqrt(r) : r);
+			}
+			for (; i < n; ++i)
+				out[i] = ROOT ? std::abs(p[i]) : std::norm(p[i]);
+		}
+	};
+
+	// Z interleaved complex values; Z must fill whole registers like AlignedMatrix rows.
+	template<class T, int Z> class alignas(64) AlignedArrayAVX512<std::complex<T>, Z> : public ComplexArrayAVX512<AlignedArrayAVX512<std::complex<T>, Z>, T>
+	{
+		static_assert((Z * sizeof(std::complex<T>)) % 64 == 0, "complex AlignedArrayAVX512 must be whole AVX-512 registers");
+
+		std::complex<T> data[Z];
+	public:
+		using ScalarType = std::complex<T>;
+		using Base = ComplexArrayAVX512<AlignedArrayAVX512<std::complex<T>, Z>, T>;
+		using Base::operator=;
+
+		const std::complex<T>* begin() const { return data; }
+		const std::complex<T>* end() const { return data + Z; }
+		std::complex<T>* begin() { return data; }
+		std::complex<T>* end() { return data + Z; }
+
+		std::complex<T>& operator[](int index) { return data[index]; }
+		const std::complex<T>& operator[](int index) const { return data[index]; }
+
+		AlignedArrayAVX512 clone() const { return *this; }
+
+		AlignedArrayAVX512 operator+(const AlignedArrayAVX512& rhs) const { return clone() += rhs; }
+		AlignedArrayAVX512 operator-(const AlignedArrayAVX512& rhs) const { return clone() -= rhs; }
+		AlignedArrayAVX512 operator*(const AlignedArrayAVX512& rhs) const { return clone() *= rhs; }
+
+		friend AlignedArrayAVX512 conj(const AlignedArrayAVX512& x) { return x.clone().conjugate(); }
+
+		friend AlignedArrayAVX512<T, Z> abs(const AlignedArrayAVX512& x)
+		{
+			AlignedArrayAVX512<T, Z> r;
+			x.Base::abs(r.begin());
+			return r;
+		}
+
+		friend AlignedArrayAVX512<T, Z> norm(const AlignedArrayAVX512& x)
+		{
+			AlignedArrayAVX512<T, Z> r;
+			x.Base::norm(r.begin());
+			return r;
+		}
+	};
+
+	// Radix-2 butterfly over n lanes: t = b*w, (a, b) <- (a + t, a - t)
+	template<class T> void butterfly2(std::complex<T>* a, std::complex<T>* b, const std::complex<T>* w, int n)
+	{
+		using Ops = detail::ComplexOps<T>;
+		using V = typename Ops::V;
+		const auto step = [&](int i, int m)
+		{
+			const auto ld = [&](const std::complex<T>* p) { return (m < Ops::L) ? Ops::load(p + i, m) : Ops::load(p + i); };
+			const auto st = [&](std::complex<T>* p, V v) { if (m < Ops::L) Ops::store(p + i, v, m); else Ops::store(p + i, v); };
+
+			const V x = ld(a);
+			const V t = Ops::mul(ld(b), ld(w));
+			st(a, Ops::add(x, t));
+			st(b, Ops::sub(x, t));
+		};
+		int i = 0;
+		for (; i + Ops::L <= n; i += Ops::L)
+			step(i, Ops::L);
+		if (i < n)
+			step(i, n - i);
+	}
+
+	// Radix-4 decimation-in-time butterfly over n lanes with twiddles w1..w3 on x1..x3 (w = e^{-2 pi i k/N} forward);
+	// inverse uses +i for the inner rotation, matching conjugated twiddles.
+	template<class T> void butterfly4(std::complex<T>* x0, std::complex<T>* x1, std::complex<T>* x2, std::complex<T>* x3,
+		const std::complex<T>* w1, const std::complex<T>* w2, const std::complex<T>* w3, int n, bool inverse = false)
+	{
+		using Ops = detail::ComplexOps<T>;
+		using V = typename Ops::V;
+		const auto step = [&](int i, int m)
+		{
+			const auto ld = [&](const std::complex<T>* p) { return (m < Ops::L) ? Ops::load(p + i, m) : Ops::load(p + i); };
+			const auto st = [&](std::complex<T>* p, V v) { if (m < Ops::L) Ops::store(p + i, v, m); else Ops::store(p + i, v); };
+
+			const V a0 = ld(x0);
+			const V a1 = Ops::mul(ld(x1), ld(w1));
+			const V a2 = Ops::mul(ld(x2), ld(w2));
+			const V a3 = Ops::mul(ld(x3), ld(w3));
+			const V t0 = Ops::add(a0, a2);
+			const V t1 = Ops::sub(a0, a2);
+			const V t2 = Ops::add(a1, a3);
+			// (a1 - a3) * -i = (im, -re) forward, * +i = (-im, re) inverse
+			const V d = Ops::swap(Ops::sub(a1, a3));
+			const V t3 = inverse ? Ops::neg_even(d) : Ops::neg_odd(d);
+			st(x0, Ops::add(t0, t2));
+			st(x1, Ops::add(t1, t3));
+			st(x2, Ops::sub(t0, t2));
+			st(x3, Ops::sub(t1, t3));
+		};
+		int i = 0;
+		for (; i + Ops::L <= n; i += Ops::L)
+			step(i, Ops::L);
+		if (i < n)
+			step(i, n - i);
+	}
+}
@@ -6,11 +6,19 @@
 #include "simd_array.hpp"
 
 #include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <chrono>
+#include <stdexcept>
+#include <exception>
 #include "sync_line.hpp"
+#include "simd_arena.hpp"
 
-#include <functional>
+#include <utility>
 #include <type_traits>
 #include <array>
+#include <algorithm>
 
 namespace simd
 {
@@ -32,9 +40,38 @@ namespace simd
 			SharedData mShared;
 
 			SyncLine<THREADS> mBarrier;
-			std::array<ThreadBatch*, THREADS> merge_pointers;
+			std::array<void*, THREADS> merge_pointers;
 			int master_res = 0;
 
+			// deterministic mode: every batch's Fold partial, reduced along a fixed tree over batch indices
+			bool mDeterministic = false;
+			std::vector<void*> mBatchSources;
+			std::vector<void*> mBatchTargets;
+
+			// other processes taking part in every Fold, see Group()
+			ReduceGroup* mGroup = nullptr;
+
+			// avx512::unroll on the Dispatcher's threads during Run(), 0 leaves them alone, see Unroll()
+			int mUnroll = 0;
+
+			struct UnrollScope
+			{
+				int saved;
+				explicit UnrollScope(int factor) : saved(avx512::unroll) { if (factor) avx512::unroll = factor; }
+				~UnrollScope() { avx512::unroll = saved; }
+			};
+
+			// Partials travel between processes as raw bytes, so only trivially copyable ones can: batches of
+			// AlignedArray/AlignedArrayAVX512, the simd_reduce.hpp partials and FoldMulti containers made of them.
+			// Partials that own heap memory (AlignedVectorAVX512, SparseVectorAVX512, SoAArray<Scalar, 0, ...>) cannot;
+			// callers skip them at compile time and Group() refuses algorithms that have any, see GroupStep.
+			template<class Op, class Partial> void ReduceAcross(Partial& partial)
+			{
+				static_assert(std::is_trivially_copyable<Partial>::value, "a Group moves Fold partials between processes as raw bytes");
+				if (mGroup)
+					mGroup->allreduce(&partial, sizeof(Partial), [](void* lhs, const void* rhs) { Op::combine(*static_cast<Partial*>(lhs), *static_cast<const Partial*>(rhs)); });
+			}
+
 			struct SlaveSet
 			{
 				Algorithm<ThreadBatch> alg[Z / (THREADS*RO)];
@@ -46,19 +83,128 @@ namespace simd
 				AlgorithmPrimary<ThreadBatch> alg_master;
 			};
 
-			std::vector<std::function<int(int t, SlaveSet*, Accumulator*)>> mStepsS;
-			std::vector<std::function<int(int t, MasterSet*, Accumulator*)>> mStepsM;
+			using Steps = std::make_index_sequence<Algorithm<ThreadBatch>::MaxStep + 1>;
+
+			// Algorithms with `static const bool FuseParallel = true;` promise that all instances take the same
+			// path through plain Parallel steps, so a run of them can be done instance by instance: each instance
+			// runs all the steps of the run before the next instance runs any. The steps must therefore not pass
+			// anything between instances through the shared per-thread Accumulator (or Shared), e.g. one step
+			// summing into acc and a later step of the run reading that sum, since it would see a partial sum.
+			template<class A, class = void> struct fuses_parallel : std::false_type {};
+			template<class A> struct fuses_parallel<A, std::enable_if_t<A::FuseParallel>> : std::true_type {};
+
+			template<int STEP, class = void> struct plain_parallel : std::false_type {};
+			template<int STEP> struct plain_parallel<STEP, std::enable_if_t<(STEP <= Algorithm<ThreadBatch>::MaxStep) &&
+				std::is_same<decltype(std::declval<Algorithm<ThreadBatch>&>()(StepTag<STEP, Step_Parallel>{})), int>::value>> : std::true_type {};
+
+			// last step of the run of plain Parallel steps starting at STEP
+			template<int STEP> static constexpr int ChainEnd()
+			{
+				if constexpr (plain_parallel<STEP + 1>::value)
+					return ChainEnd<STEP + 1>();
+				else
+					return STEP;
+			}
+
+			template<int STEP, class = void> struct async_fold : std::false_type {};
+			template<int STEP> struct async_fold<STEP, std::enable_if_t<
+				is_fold_async<decltype(std::declval<Algorithm<ThreadBatch>&>()(StepTag<STEP, Step_Parallel>{}))>::value>> : std::true_type {};
+
+			// FoldAsync state of one step: two sets of per-thread partial buffers, used by alternate generations
+			struct AsyncSlot
+			{
+				void* buffers = nullptr;
+				std::array<int, THREADS> issued{};
+				alignas(64) std::atomic<int> arrived[2] = { 0, 0 };
+				alignas(64) std::atomic<int> done[2] = { 0, 0 };
+			};
+			std::array<AsyncSlot, Algorithm<ThreadBatch>::MaxStep + 1> mAsync;
+
+			// Vote state of one step: round g is tallied in words[g & 1] as tag g + 1 (high half), vote count
+			// (low 16 bits) and the continue/expired flags. Reset by Run().
+			struct VoteSlot
+			{
+				std::array<int, THREADS> issued{};
+				alignas(64) std::atomic<uint64_t> words[2] = { 0, 0 };
+			};
+			std::array<VoteSlot, Algorithm<ThreadBatch>::MaxStep + 1> mVotes;
+			static const uint64_t vote_continue = 1ull << 16;
+			static const uint64_t vote_expired  = 1ull << 17;
+
+			// incremental mode, see Incremental(): instances outlive Run(), later Runs replay mTrace on dirty batches only
+			bool mIncremental = false;
+			bool mKept = false;
+			bool mPriming = false;
+			bool mAllDirty = false;
+			std::vector<uint64_t> mDirty;
+			std::vector<int> mTrace;
+
+			// per Fold step: Z/RO batch partials, THREADS thread totals, one scratch partial; the target of the last full Run
+			struct FoldCache
+			{
+				void* partials = nullptr;
+				void* target = nullptr;
+			};
+			std::array<FoldCache, Algorithm<ThreadBatch>::MaxStep + 1> mFoldCache;
+
+			// time budget of a Run() and external cancellation, both seen by Vote steps only
+			std::chrono::steady_clock::duration mBudget{};
+			std::chrono::steady_clock::time_point mDeadline{};
+			std::atomic<bool> mCancel{ false };
+			bool mExpired = false;
+
+			// per-thread storage, allocated once and reconstructed in place on every Run()
+			HugePageArena mArena;
+			std::pmr::memory_resource* mResource;
+			std::array<void*, THREADS> mSets{};
+			std::array<void*, THREADS> mAccs{};
+
+			// persistent workers, woken once per Run() or Parallel() to execute mJob
+			using Job = void(*)(void* ctx, int t);
+			Job   mJob = nullptr;
+			void* mJobCtx = nullptr;
+
+			std::mutex m_run;
+			std::condition_variable cv_run;
+			std::condition_variable cv_done;
+			int  mGeneration = 0;
+			int  mRunning = 0;
+			bool mStop = false;
 		public:
 
 			template<int STEP> int_t<decltype(((Algorithm<ThreadBatch>*)nullptr)->operator()(StepTag<STEP, Step_Parallel>{}))> RunStep(int t, SlaveSet* set, Accumulator* acc)
 			{
 				using ret_type = decltype(((Algorithm<ThreadBatch>*)nullptr)->operator()(StepTag<STEP, Step_Parallel>{}));
-				if constexpr (std::is_same<ret_type, Fold<ThreadBatch>>::value)
+				if constexpr (is_fold_async<ret_type>::value)
 				{
+					return RunFoldAsync<STEP>(t, set);
+				}
+				else if constexpr (is_vote<ret_type>::value)
+				{
+					return RunVote<STEP>(t, set);
+				}
+				else if constexpr (is_fold<ret_type>::value)
+				{
+					using Op = typename ret_type::Monoid;
 					ret_type res = set->alg[0](StepTag<STEP, Step_Parallel>{});
+
+					if (mDeterministic)
+					{
+						const int first = (Z / (THREADS*RO))*t;
+						mBatchSources[first] = res.merge_source;
+						for (int i = 1; i < (Z / (THREADS*RO)); ++i)
+						{
+							mBatchSources[first + i] = set->alg[i](StepTag<STEP, Step_Parallel>{}).merge_source;
+						}
+
+						ReduceTree<Op, std::remove_pointer_t<decltype(res.merge_source)>>(t);
+						mBarrier.WaitSlave();
+						return res.next_step;
+					}
+
 					for (int i = 1; i < (Z / (THREADS*RO)); ++i)
 					{
-						*(res.merge_source) += *(set->alg[i](StepTag<STEP, Step_Parallel>{}).merge_source);
+						Op::combine(*(res.merge_source), *(set->alg[i](StepTag<STEP, Step_Parallel>{}).merge_source));
 					}
 
 					merge_pointers[t] = res.merge_source;
@@ -67,7 +213,7 @@ namespace simd
 				}
 				else
 				{
-					if constexpr (std::is_same<ret_type, FoldAcc<ThreadBatch>>::value)
+					if constexpr (is_fold_acc<ret_type>::value)
 					{
 						ret_type res = set->alg[0](StepTag<STEP, Step_Parallel>{});
 						for (int i = 1; i < (Z / (THREADS*RO)); ++i)
@@ -89,7 +235,7 @@ namespace simd
 								res = set->alg[i](StepTag<STEP, Step_Parallel>{});
 							}
 
-							merge_pointers[t] = reinterpret_cast<ThreadBatch*>(res.merge_source);
+							merge_pointers[t] = res.merge_source;
 							mBarrier.WaitSlave();
 							return res.next_step;
 						}
@@ -98,7 +244,7 @@ namespace simd
 							ret_type res = 0;
 							for (auto& instance : set->alg)
 							{
-								res = instance(StepTag<STEP, Step_Parallel>{});
+								res = RunChain<STEP>(instance);
 							}
 							return res;
 						}
@@ -109,22 +255,53 @@ namespace simd
 			template<int STEP> int_t<decltype(((Algorithm<ThreadBatch>*)nullptr)->operator()(StepTag<STEP, Step_Parallel>{}))> RunStep(int t, MasterSet* set, Accumulator* acc)
 			{
 				using ret_type = decltype(((Algorithm<ThreadBatch>*)nullptr)->operator()(StepTag<STEP, Step_Parallel>{}));
-				if constexpr (std::is_same<ret_type, Fold<ThreadBatch>>::value)
+				if constexpr (is_fold_async<ret_type>::value)
+				{
+					return RunFoldAsync<STEP>(t, set);
+				}
+				else if constexpr (is_vote<ret_type>::value)
+				{
+					return RunVote<STEP>(t, set);
+				}
+				else if constexpr (is_fold<ret_type>::value)
 				{
+					using Op = typename ret_type::Monoid;
+					using Partial = std::remove_pointer_t<decltype(ret_type::merge_source)>;
 					ret_type res = set->alg_master(StepTag<STEP, Step_Parallel>{});
+
+					if (mDeterministic)
+					{
+						mBatchSources[0] = res.merge_source;
+						for (int i = 0; i < (Z / (THREADS*RO)) - 1; ++i)
+						{
+							mBatchSources[i + 1] = set->alg[i](StepTag<STEP, Step_Parallel>{}).merge_source;
+						}
+
+						ReduceTree<Op, Partial>(0);
+						mBarrier.WaitMaster();
+						ReduceTree<Op, Partial>(-1);
+						if constexpr (std::is_trivially_copyable<Partial>::value)
+							ReduceAcross<Op>(*static_cast<Partial*>(mBatchSources[0]));
+						Op::finish(*static_cast<Partial*>(mBatchSources[0]), *(res.merge_target));
+						mBarrier.ReleaseMaster();
+						return res.next_step;
+					}
+
 					for (int i = 0; i < (Z / (THREADS*RO)) - 1; ++i)
 					{
-						*(res.merge_source) += *(set->alg[i](StepTag<STEP, Step_Parallel>{}).merge_source);
+						Op::combine(*(res.merge_source), *(set->alg[i](StepTag<STEP, Step_Parallel>{}).merge_source));
 					}
 
 					mBarrier.WaitMaster();
 
 					for (int tn = 1; tn < THREADS; tn++)
 					{
-						*(res.merge_source) += *(merge_pointers[tn]);
+						Op::combine(*(res.merge_source), *static_cast<decltype(res.merge_source)>(merge_pointers[tn]));
 					}
 
-					*(res.merge_target) = res.merge_source->fold();
+					if constexpr (std::is_trivially_copyable<Partial>::value)
+						ReduceAcross<Op>(*(res.merge_source));
+					Op::finish(*(res.merge_source), *(res.merge_target));
 
 					mBarrier.ReleaseMaster();
 
@@ -132,8 +309,9 @@ namespace simd
 				}
 				else
 				{
-					if constexpr (std::is_same<ret_type, FoldAcc<ThreadBatch>>::value)
+					if constexpr (is_fold_acc<ret_type>::value)
 					{
+						using Op = typename ret_type::Monoid;
 						ret_type res = set->alg_master(StepTag<STEP, Step_Parallel>{});
 						for (int i = 0; i < (Z / (THREADS*RO)) - 1; ++i)
 						{
@@ -144,10 +322,12 @@ namespace simd
 
 						for (int tn = 1; tn < THREADS; tn++)
 						{
-							*(res.merge_source) += *(merge_pointers[tn]);
+							Op::combine(*(res.merge_source), *static_cast<decltype(res.merge_source)>(merge_pointers[tn]));
 						}
 
-						*(res.merge_target) = res.merge_source->fold();
+						if constexpr (std::is_trivially_copyable<std::remove_pointer_t<decltype(res.merge_source)>>::value)
+							ReduceAcross<Op>(*(res.merge_source));
+						Op::finish(*(res.merge_source), *(res.merge_target));
 
 						mBarrier.ReleaseMaster();
 
@@ -157,6 +337,7 @@ namespace simd
 					{
 						if constexpr (std::is_base_of<FoldMultiTag, ret_type>::value)
 						{
+							using Op = typename ret_type::Monoid;
 							ret_type res = set->alg_master(StepTag<STEP, Step_Parallel>{});
 							for (int i = 0; i < (Z / (THREADS*RO)) - 1; ++i)
 							{
@@ -167,14 +348,20 @@ namespace simd
 
 							for (int tn = 1; tn < THREADS; tn++)
 							{
-								auto mp = reinterpret_cast<decltype(res.merge_source)>(merge_pointers[tn]);
+								auto mp = static_cast<decltype(res.merge_source)>(merge_pointers[tn]);
 
 								//sum_gradients(res.merge_source, mp);
-								traverse_accums(res.merge_source, mp, [](auto& lhs, const auto& rhs) { lhs += rhs; });
+								traverse_accums(res.merge_source, mp, [](auto& lhs, const auto& rhs) { Op::combine(lhs, rhs); });
+							}
+
+							if constexpr (std::is_trivially_copyable<std::remove_pointer_t<decltype(res.merge_source)>>::value)
+							{
+								if (mGroup)
+									traverse_accums(res.merge_source, res.merge_source, [this](auto& lhs, const auto&) { this->template ReduceAcross<Op>(lhs); });
 							}
 
 							//traverse_gradients(res.merge_target, res.merge_source, [](auto& lhs, const auto& rhs) { lhs = rhs.fold(); });
-							traverse_accums(res.merge_target, res.merge_source, [](auto& lhs, const auto& rhs) { lhs = rhs.fold(); });
+							traverse_accums(res.merge_target, res.merge_source, [](auto& lhs, const auto& rhs) { Op::finish(rhs, lhs); });
 
 							mBarrier.ReleaseMaster();
 
@@ -184,9 +371,9 @@ namespace simd
 						{
 							for (auto& instance : set->alg)
 							{
-								instance(StepTag<STEP, Step_Parallel>{});
+								RunChain<STEP>(instance);
 							}
-							return set->alg_master(StepTag<STEP, Step_Parallel>{});
+							return RunChain<STEP>(set->alg_master);
 						}
 					}
 				}
@@ -268,71 +455,839 @@ namespace simd
 				return res;
 			}
 
+			template<int STEP> std::enable_if_t<is_scan<decltype(((Algorithm<ThreadBatch>*)nullptr)->operator()(StepTag<STEP, Step_Scan>{}))>::value, int>
+				RunStep(int t, SlaveSet* set, Accumulator* acc)
+			{
+				using ret_type = decltype(((Algorithm<ThreadBatch>*)nullptr)->operator()(StepTag<STEP, Step_Scan>{}));
+				std::array<ret_type, Z / (THREADS*RO)> parts;
+				for (int i = 0; i < Z / (THREADS*RO); ++i)
+				{
+					parts[i] = set->alg[i](StepTag<STEP, Step_Scan>{});
+				}
+				return ScanParts(t, parts);
+			}
+
+			template<int STEP> std::enable_if_t<is_scan<decltype(((Algorithm<ThreadBatch>*)nullptr)->operator()(StepTag<STEP, Step_Scan>{}))>::value, int>
+				RunStep(int t, MasterSet* set, Accumulator* acc)
+			{
+				using ret_type = decltype(((Algorithm<ThreadBatch>*)nullptr)->operator()(StepTag<STEP, Step_Scan>{}));
+				std::array<ret_type, Z / (THREADS*RO)> parts;
+				parts[0] = set->alg_master(StepTag<STEP, Step_Scan>{});
+				for (int i = 0; i < Z / (THREADS*RO) - 1; ++i)
+				{
+					parts[i + 1] = set->alg[i](StepTag<STEP, Step_Scan>{});
+				}
+				return ScanParts(t, parts);
+			}
+
+			// Two-pass scan over the instances' totals in batch order: each thread scans its own batches,
+			// the master scans the THREADS thread totals into per-thread offsets, each thread adds its offset.
+			// Deterministic mode has the master walk all batches in order, so carries do not depend on THREADS.
+			template<class Res, size_t P> int ScanParts(int t, std::array<Res, P>& parts)
+			{
+				using Op = typename Res::Monoid;
+				using S = std::remove_pointer_t<decltype(Res::carry)>;
+
+				if (mDeterministic)
+				{
+					for (size_t i = 0; i < P; ++i)
+					{
+						mBatchSources[t*P + i] = parts[i].total;
+						mBatchTargets[t*P + i] = parts[i].carry;
+					}
+
+					if (t == 0)
+					{
+						mBarrier.WaitMaster();
+						S run = Op::template identity<S>();
+						for (int b = 0; b < Z / RO; ++b)
+						{
+							const S total = *static_cast<S*>(mBatchSources[b]);
+							*static_cast<S*>(mBatchTargets[b]) = run;
+							Op::combine(run, total);
+						}
+						mBarrier.ReleaseMaster();
+					}
+					else
+					{
+						mBarrier.WaitSlave();
+					}
+					return parts[0].next_step;
+				}
+
+				S local = Op::template identity<S>();
+				for (auto& part : parts)
+				{
+					const S total = *part.total;
+					*part.carry = local;
+					Op::combine(local, total);
+				}
+
+				// the master replaces every thread's total by the combination of the totals before it
+				merge_pointers[t] = &local;
+				if (t == 0)
+				{
+					mBarrier.WaitMaster();
+					S run = Op::template identity<S>();
+					for (int tn = 0; tn < THREADS; ++tn)
+					{
+						S* p = static_cast<S*>(merge_pointers[tn]);
+						const S total = *p;
+						*p = run;
+						Op::combine(run, total);
+					}
+					mBarrier.ReleaseMaster();
+				}
+				else
+				{
+					mBarrier.WaitSlave();
+				}
+
+				for (auto& part : parts)
+				{
+					S c = local;
+					Op::combine(c, *part.carry);
+					*part.carry = c;
+				}
+				return parts[0].next_step;
+			}
+
+			template<class F> static void ForEachInstance(SlaveSet* set, const F& f)
+			{
+				for (auto& instance : set->alg)
+					f(instance);
+			}
+
+			template<class F> static void ForEachInstance(MasterSet* set, const F& f)
+			{
+				f(set->alg_master);
+				for (auto& instance : set->alg)
+					f(instance);
+			}
+
+			static void WaitFor(const std::atomic<int>& counter, int value)
+			{
+				while (counter.load(std::memory_order_acquire) < value)
+					std::this_thread::yield();
+			}
+
+			// Generation g of a FoldAsync step uses buffer set g & 1, so a thread only waits when it is two folds
+			// ahead of the slowest one. Partials are merged in thread order whichever thread arrives last.
+			template<int STEP, class Set> int RunFoldAsync(int t, Set* set)
+			{
+				using ret_type = decltype(((Algorithm<ThreadBatch>*)nullptr)->operator()(StepTag<STEP, Step_Parallel>{}));
+				using Op = typename ret_type::Monoid;
+				using Partial = std::remove_pointer_t<decltype(ret_type::merge_source)>;
+
+				AsyncSlot& slot = mAsync[STEP];
+				const int gen = slot.issued[t]++;
+				const int parity = gen & 1;
+				WaitFor(slot.done[parity], gen - 1);
+
+				Partial* buffers = static_cast<Partial*>(slot.buffers) + parity*THREADS;
+				ret_type first{};
+				bool have = false;
+				ForEachInstance(set, [&](auto& instance)
+				{
+					ret_type res = instance(StepTag<STEP, Step_Parallel>{});
+					if (have)
+					{
+						Op::combine(buffers[t], *res.merge_source);
+					}
+					else
+					{
+						buffers[t] = *res.merge_source;
+						first = res;
+						have = true;
+					}
+					if (res.future)
+						res.future->arm(&slot.done[parity], gen + 1, res.merge_target);
+				});
+
+				if (slot.arrived[parity].fetch_add(1, std::memory_order_acq_rel) + 1 == THREADS)
+				{
+					for (int tn = 1; tn < THREADS; ++tn)
+					{
+						Op::combine(buffers[0], buffers[tn]);
+					}
+					if constexpr (std::is_trivially_copyable<Partial>::value)
+						ReduceAcross<Op>(buffers[0]);
+					Op::finish(buffers[0], *first.merge_target);
+
+					slot.arrived[parity].store(0, std::memory_order_relaxed);
+					slot.done[parity].store(gen + 1, std::memory_order_release);
+				}
+				return first.next_step;
+			}
+
+			bool Expiring() const
+			{
+				return mCancel.load(std::memory_order_relaxed) ||
+					(mBudget.count() > 0 && std::chrono::steady_clock::now() >= mDeadline);
+			}
+
+			// Round g of a Vote step: run the instances, wait until every thread has tallied round g - 1, then
+			// either leave (that round decided) or tally round g. All threads read the same complete word, so
+			// they leave in the same round; a thread only waits for threads a whole round behind it.
+			// Tallying g after reading g - 1 keeps word (g + 1) & 1 from being reused before everyone read it.
+			template<int STEP, class Set> int RunVote(int t, Set* set)
+			{
+				VoteSlot& slot = mVotes[STEP];
+				const int gen = slot.issued[t]++;
+
+				Vote first{};
+				bool have = false;
+				bool done = true;
+				ForEachInstance(set, [&](auto& instance)
+				{
+					const Vote res = instance(StepTag<STEP, Step_Parallel>{});
+					done = done && res.done;
+					if (!have)
+					{
+						first = res;
+						have = true;
+					}
+				});
+
+				if (gen > 0)
+				{
+					const std::atomic<uint64_t>& prev = slot.words[(gen - 1) & 1];
+					const uint64_t complete = (uint64_t(gen) << 32) | uint64_t(THREADS);
+					uint64_t w = prev.load(std::memory_order_acquire);
+					while ((w & ~(vote_continue | vote_expired)) != complete)
+					{
+						std::this_thread::yield();
+						w = prev.load(std::memory_order_acquire);
+					}
+
+					if (!(w & vote_continue) || (w & vote_expired))
+					{
+						if (t == 0)
+							mExpired = (w & vote_expired) != 0;
+						return first.exit_step;
+					}
+				}
+
+				const uint64_t tag = uint64_t(gen + 1) << 32;
+				const uint64_t flags = (done ? 0 : vote_continue) | (Expiring() ? vote_expired : 0);
+				std::atomic<uint64_t>& word = slot.words[gen & 1];
+				uint64_t w = word.load(std::memory_order_relaxed);
+				while (!word.compare_exchange_weak(w, (((w & ~0xFFFFFFFFull) == tag) ? w + 1 : tag + 1) | flags, std::memory_order_acq_rel, std::memory_order_relaxed))
+				{
+				}
+				return first.next_step;
+			}
+
+			template<int STEP, class Kind, class = void> struct has_step : std::false_type {};
+			template<int STEP, class Kind> struct has_step<STEP, Kind,
+				std::void_t<decltype(std::declval<Algorithm<ThreadBatch>&>()(StepTag<STEP, Kind>{}))>> : std::true_type {};
+
+			template<int STEP> static constexpr bool IncrementalStep()
+			{
+				if constexpr (has_step<STEP, Step_Parallel>::value)
+				{
+					using ret_type = decltype(std::declval<Algorithm<ThreadBatch>&>()(StepTag<STEP, Step_Parallel>{}));
+					return std::is_same<ret_type, int>::value || is_fold<ret_type>::value;
+				}
+				else
+				{
+					return !has_step<STEP, Step_Accumulate>::value && !has_step<STEP, Step_AccReset>::value && !has_step<STEP, Step_Scan>::value;
+				}
+			}
+
+			template<size_t... S> static constexpr bool IncrementalSteps(std::index_sequence<S...>) { return (IncrementalStep<int(S)>() && ...); }
+
+			// whether the step's partials can be reduced across a Group (FoldMulti sources field by field), see ReduceAcross
+			template<int STEP> static constexpr bool GroupStep()
+			{
+				if constexpr (has_step<STEP, Step_Parallel>::value)
+				{
+					using ret_type = decltype(std::declval<Algorithm<ThreadBatch>&>()(StepTag<STEP, Step_Parallel>{}));
+					if constexpr (is_fold<ret_type>::value || is_fold_acc<ret_type>::value || is_fold_async<ret_type>::value ||
+						std::is_base_of<FoldMultiTag, ret_type>::value)
+						return std::is_trivially_copyable<std::remove_pointer_t<decltype(ret_type::merge_source)>>::value;
+				}
+				return true;
+			}
+
+			template<size_t... S> static constexpr bool GroupSteps(std::index_sequence<S...>) { return (GroupStep<int(S)>() && ...); }
+
+			bool Dirty(int batch) const { return mPriming || ((mDirty[batch >> 6] >> (batch & 63)) & 1); }
+
+			// f(batch index, instance) over a thread's instances
+			template<class F> static void ForEachBatch(int t, SlaveSet* set, const F& f)
+			{
+				for (int i = 0; i < Z / (THREADS*RO); ++i)
+					f(t*(Z / (THREADS*RO)) + i, set->alg[i]);
+			}
+
+			template<class F> static void ForEachBatch(int, MasterSet* set, const F& f)
+			{
+				f(0, set->alg_master);
+				for (int i = 0; i < Z / (THREADS*RO) - 1; ++i)
+					f(i + 1, set->alg[i]);
+			}
+
+			// one step of an incremental Run, on the dirty batches only (all of them while priming)
+			template<int STEP, class Set> int RunStepIncremental(int t, Set* set)
+			{
+				if constexpr (has_step<STEP, Step_Parallel>::value)
+				{
+					using ret_type = decltype(std::declval<Algorithm<ThreadBatch>&>()(StepTag<STEP, Step_Parallel>{}));
+					if constexpr (is_fold<ret_type>::value)
+					{
+						return RunFoldIncremental<STEP>(t, set);
+					}
+					else if constexpr (std::is_same<ret_type, int>::value)
+					{
+						int next = -1;
+						ForEachBatch(t, set, [&](int b, auto& instance)
+						{
+							if (Dirty(b))
+								next = instance(StepTag<STEP, Step_Parallel>{});
+						});
+						return next;
+					}
+					else
+					{
+						return -1;
+					}
+				}
+				else if constexpr (has_step<STEP, Step_Separate>::value)
+				{
+					int next = -1;
+					ForEachBatch(t, set, [&](int b, auto& instance)
+					{
+						if (Dirty(b))
+						{
+							for (int j = 0; j < RO; ++j)
+								next = instance(StepTag<STEP, Step_Separate>{ b*RO + j, j });
+						}
+					});
+					return next;
+				}
+				else if constexpr (has_step<STEP, Step_Singlethreaded>::value)
+				{
+					return RunStep<STEP>(t, set, nullptr);
+				}
+				else
+				{
+					return -1;
+				}
+			}
+
+			// Fold over cached batch partials: dirty batches replace their partial, and the thread total follows by
+			// uncombine/combine for invertible monoids, by recombining the thread's cached partials otherwise.
+			template<int STEP, class Set> int RunFoldIncremental(int t, Set* set)
+			{
+				using ret_type = decltype(std::declval<Algorithm<ThreadBatch>&>()(StepTag<STEP, Step_Parallel>{}));
+				using Op = typename ret_type::Monoid;
+				using Partial = std::remove_pointer_t<decltype(ret_type::merge_source)>;
+				using Result = std::remove_pointer_t<decltype(ret_type::merge_target)>;
+				constexpr bool invertible = is_invertible<Op, Partial>::value;
+				const int P = Z / (THREADS*RO);
+
+				FoldCache& fc = mFoldCache[STEP];
+				Partial* cache = static_cast<Partial*>(fc.partials);
+				Partial& total = cache[Z/RO + t];
+				const bool update = invertible && !mPriming;
+
+				int next = -1;
+				ForEachBatch(t, set, [&](int b, auto& instance)
+				{
+					if (!Dirty(b))
+						return;
+					ret_type res = instance(StepTag<STEP, Step_Parallel>{});
+					next = res.next_step;
+					if (b == 0)
+						fc.target = res.merge_target;
+					if constexpr (invertible)
+					{
+						if (update)
+							Op::uncombine(total, cache[b]);
+					}
+					cache[b] = *res.merge_source;
+					if constexpr (invertible)
+					{
+						if (update)
+							Op::combine(total, cache[b]);
+					}
+				});
+
+				if (!update)
+				{
+					total = cache[t*P];
+					for (int i = 1; i < P; ++i)
+						Op::combine(total, cache[t*P + i]);
+				}
+
+				if (t != 0)
+				{
+					merge_pointers[t] = &total;
+					mBarrier.WaitSlave();
+					return next;
+				}
+
+				mBarrier.WaitMaster();
+				Partial& sum = cache[Z/RO + THREADS];
+				sum = total;
+				for (int tn = 1; tn < THREADS; ++tn)
+					Op::combine(sum, cache[Z/RO + tn]);
+				if constexpr (std::is_trivially_copyable<Partial>::value)
+					ReduceAcross<Op>(sum);
+				Op::finish(sum, *static_cast<Result*>(fc.target));
+				mBarrier.ReleaseMaster();
+				return next;
+			}
+
+			template<class Set, size_t... S> int RunStepIncrementalAt(int step, int t, Set* set, std::index_sequence<S...>)
+			{
+				int next = -1;
+				(void)((step == int(S) && (next = RunStepIncremental<int(S)>(t, set), true)) || ...);
+				return next;
+			}
+
+			// priming: build the instances, run every batch and record the steps (master); otherwise replay the record
+			template<class Set> void RunIncremental(int t)
+			{
+				if (mPriming)
+				{
+					auto set = new (mSets[t]) Set();
+					auto acc = new (mAccs[t]) Accumulator();
+					ForEachInstance(set, [&](auto& a) { a.init(&mShared, acc); });
+
+					int step = 0;
+					while (step >= 0)
+					{
+						if (t == 0)
+							mTrace.push_back(step);
+						step = RunStepIncrementalAt(step, t, set, Steps{});
+					}
+				}
+				else
+				{
+					for (int step : mTrace)
+						RunStepIncrementalAt(step, t, static_cast<Set*>(mSets[t]), Steps{});
+				}
+			}
+
+			void ReleaseKept()
+			{
+				if (!mKept)
+					return;
+				static_cast<MasterSet*>(mSets[0])->~MasterSet();
+				static_cast<Accumulator*>(mAccs[0])->~Accumulator();
+				for (int t = 1; t < THREADS; ++t)
+				{
+					static_cast<SlaveSet*>(mSets[t])->~SlaveSet();
+					static_cast<Accumulator*>(mAccs[t])->~Accumulator();
+				}
+				mKept = false;
+			}
+
+			template<size_t... S> void CreateFoldCache(std::index_sequence<S...>) { (CreateFoldCacheAt<int(S)>(), ...); }
+			template<size_t... S> void DestroyFoldCache(std::index_sequence<S...>) { (DestroyFoldCacheAt<int(S)>(), ...); }
+
+			template<int STEP> void CreateFoldCacheAt()
+			{
+				if constexpr (has_step<STEP, Step_Parallel>::value)
+				{
+					using ret_type = decltype(std::declval<Algorithm<ThreadBatch>&>()(StepTag<STEP, Step_Parallel>{}));
+					if constexpr (is_fold<ret_type>::value)
+					{
+						using Partial = std::remove_pointer_t<decltype(ret_type::merge_source)>;
+						const int n = Z/RO + THREADS + 1;
+						auto p = static_cast<Partial*>(mResource->allocate(n * sizeof(Partial), std::max<size_t>(alignof(Partial), 64)));
+						for (int i = 0; i < n; ++i)
+							new (p + i) Partial();
+						mFoldCache[STEP].partials = p;
+					}
+				}
+			}
+
+			template<int STEP> void DestroyFoldCacheAt()
+			{
+				if constexpr (has_step<STEP, Step_Parallel>::value)
+				{
+					using ret_type = decltype(std::declval<Algorithm<ThreadBatch>&>()(StepTag<STEP, Step_Parallel>{}));
+					if constexpr (is_fold<ret_type>::value)
+					{
+						using Partial = std::remove_pointer_t<decltype(ret_type::merge_source)>;
+						const int n = Z/RO + THREADS + 1;
+						auto p = static_cast<Partial*>(mFoldCache[STEP].partials);
+						for (int i = 0; i < n; ++i)
+							p[i].~Partial();
+						mResource->deallocate(p, n * sizeof(Partial), std::max<size_t>(alignof(Partial), 64));
+						mFoldCache[STEP] = FoldCache{};
+					}
+				}
+			}
+
+			template<size_t... S> void CreateAsync(std::index_sequence<S...>) { (CreateAsyncAt<int(S)>(), ...); }
+			template<size_t... S> void DestroyAsync(std::index_sequence<S...>) { (DestroyAsyncAt<int(S)>(), ...); }
+
+			template<int STEP> void CreateAsyncAt()
+			{
+				if constexpr (async_fold<STEP>::value)
+				{
+					using Partial = std::remove_pointer_t<decltype(decltype(std::declval<Algorithm<ThreadBatch>&>()(StepTag<STEP, Step_Parallel>{}))::merge_source)>;
+					auto p = static_cast<Partial*>(mResource->allocate(2 * THREADS * sizeof(Partial), std::max<size_t>(alignof(Partial), 64)));
+					for (int i = 0; i < 2 * THREADS; ++i)
+						new (p + i) Partial();
+					mAsync[STEP].buffers = p;
+				}
+			}
+
+			template<int STEP> void DestroyAsyncAt()
+			{
+				if constexpr (async_fold<STEP>::value)
+				{
+					using Partial = std::remove_pointer_t<decltype(decltype(std::declval<Algorithm<ThreadBatch>&>()(StepTag<STEP, Step_Parallel>{}))::merge_source)>;
+					auto p = static_cast<Partial*>(mAsync[STEP].buffers);
+					for (int i = 0; i < 2 * THREADS; ++i)
+						p[i].~Partial();
+					mResource->deallocate(p, 2 * THREADS * sizeof(Partial), std::max<size_t>(alignof(Partial), 64));
+				}
+			}
+
+			// Pairwise tree over the Z/RO batch partials: at width w, batch `left` absorbs batch `left + w`.
+			// The tree only depends on Z/RO, so results are bitwise identical for any THREADS.
+			// t >= 0 reduces the nodes that lie inside thread t's batches, t < 0 (master, after the barrier) the rest.
+			template<class Op, class Partial> void ReduceTree(int t)
+			{
+				const int B = Z / RO;
+				const int P = Z / (THREADS*RO);
+				const int begin = (t < 0) ? 0 : t*P;
+				const int end   = (t < 0) ? B : (t + 1)*P;
+
+				for (int w = 1; w < B; w *= 2)
+				{
+					for (int left = (begin + 2*w - 1) / (2*w) * (2*w); left + w < end; left += 2*w)
+					{
+						const int last = std::min(left + 2*w, B) - 1;
+						const bool local = (left / P) == (last / P);
+						if (local == (t >= 0))
+							Op::combine(*static_cast<Partial*>(mBatchSources[left]), *static_cast<Partial*>(mBatchSources[left + w]));
+					}
+				}
+			}
+
+			// Plain Parallel step STEP on one instance; with FuseParallel the following plain Parallel steps
+			// run right away on the same instance while its batch is still in cache, returning the first step outside the run.
+			template<int STEP, class Alg> static int RunChain(Alg& instance)
+			{
+				if constexpr (fuses_parallel<Algorithm<ThreadBatch>>::value && ChainEnd<STEP>() > STEP)
+				{
+					int step = STEP;
+					while (step >= STEP && step <= ChainEnd<STEP>())
+						step = CallChain<STEP>(instance, step, std::make_index_sequence<ChainEnd<STEP>() - STEP + 1>{});
+					return step;
+				}
+				else
+				{
+					return instance(StepTag<STEP, Step_Parallel>{});
+				}
+			}
+
+			template<int FIRST, class Alg, size_t... I> static int CallChain(Alg& instance, int step, std::index_sequence<I...>)
+			{
+				int next = -1;
+				(void)((step == FIRST + int(I) && (next = instance(StepTag<FIRST + int(I), Step_Parallel>{}), true)) || ...);
+				return next;
+			}
+
+			// Compile-time step table: a chain of direct RunStep<S> calls the compiler can inline and turn into a jump table
+			template<class Set, size_t... S> int RunStepAt(int step, int t, Set* set, Accumulator* acc, std::index_sequence<S...>)
+			{
+				int next = -1;
+				(void)((step == int(S) && (next = RunStep<int(S)>(t, set, acc), true)) || ...);
+				return next;
+			}
+
 			void RunWorkerS(int t)
 			{
-				auto alg = std::make_unique<SlaveSet>();
-				auto acc = std::make_unique<Accumulator>();
+				if (mIncremental)
+					return RunIncremental<SlaveSet>(t);
+
+				auto alg = new (mSets[t]) SlaveSet();
+				auto acc = new (mAccs[t]) Accumulator();
 
 				for (auto& a : alg->alg)
-					a.init(&mShared, acc.get());
+					a.init(&mShared, acc);
 
 				int step = 0;
 				while (step >= 0)
 				{
-					step = mStepsS[step](t, alg.get(), acc.get());
+					step = RunStepAt(step, t, alg, acc, Steps{});
 				}
+
+				alg->~SlaveSet();
+				acc->~Accumulator();
 			}
 
 			void RunWorkerM(int t)
 			{
-				auto alg = std::make_unique<MasterSet>();
-				auto acc = std::make_unique<Accumulator>();
+				if (mIncremental)
+					return RunIncremental<MasterSet>(t);
+
+				auto alg = new (mSets[t]) MasterSet();
+				auto acc = new (mAccs[t]) Accumulator();
 
 				for (auto& a : alg->alg)
-					a.init(&mShared, acc.get());
-				alg->alg_master.init(&mShared, acc.get());
+					a.init(&mShared, acc);
+				alg->alg_master.init(&mShared, acc);
 
 				int step = 0;
 				while (step >= 0)
 				{
-					step = mStepsM[step](t, alg.get(), acc.get());
+					step = RunStepAt(step, t, alg, acc, Steps{});
 				}
+
+				alg->~MasterSet();
+				acc->~Accumulator();
 			}
 
-			template<int step> void FillSteps()
+			void RunPool(int t)
 			{
-				mStepsS.push_back([this](int t, SlaveSet* alg, Accumulator* acc)->int { return RunStep<step>(t, alg, acc); });
-				mStepsM.push_back([this](int t, MasterSet* alg, Accumulator* acc)->int { return RunStep<step>(t, alg, acc); });
+				int seen = 0;
+				while (true)
+				{
+					{
+						std::unique_lock<std::mutex> l(m_run);
+						while (!mStop && mGeneration == seen)
+							cv_run.wait(l);
+						if (mStop)
+							return;
+						seen = mGeneration;
+					}
 
-				FillSteps<step + 1>();
-			}
+					mJob(mJobCtx, t);
 
-			template<> void FillSteps<Algorithm<ThreadBatch>::MaxStep + 1>()
-			{}
+					std::lock_guard<std::mutex> l(m_run);
+					if (--mRunning == 0)
+						cv_done.notify_one();
+				}
+			}
 
 		public:
-			Dispatcher()
+			// resource backs the per-thread algorithm sets and accumulators, the built-in huge page arena by default
+			explicit Dispatcher(std::pmr::memory_resource* resource = nullptr)
+				: mBatchSources(Z / RO), mBatchTargets(Z / RO), mResource(resource ? resource : &mArena)
 			{
-				FillSteps<0>();
+				mSets[0] = mResource->allocate(sizeof(MasterSet), std::max<size_t>(alignof(MasterSet), 64));
+				mAccs[0] = mResource->allocate(sizeof(Accumulator), std::max<size_t>(alignof(Accumulator), 64));
+				for (int t = 1; t < THREADS; ++t)
+				{
+					mSets[t] = mResource->allocate(sizeof(SlaveSet), std::max<size_t>(alignof(SlaveSet), 64));
+					mAccs[t] = mResource->allocate(sizeof(Accumulator), std::max<size_t>(alignof(Accumulator), 64));
+				}
+				CreateAsync(Steps{});
 			}
 
-			SharedData& Shared() { return mShared; }
+			Dispatcher(const Dispatcher&) = delete;
+			Dispatcher& operator=(const Dispatcher&) = delete;
 
-			void Run()
+			~Dispatcher()
 			{
-				workers.emplace_back(&Dispatcher::RunWorkerM, this, 0);
-
-				for (int t = 1; t < THREADS; ++t)
 				{
-					workers.emplace_back(&Dispatcher::RunWorkerS, this, t);
+					std::lock_guard<std::mutex> l(m_run);
+					mStop = true;
 				}
+				cv_run.notify_all();
 
 				for (auto& w : workers)
 				{
 					w.join();
 				}
 
-				workers.clear();
+				Incremental(false);
+				DestroyAsync(Steps{});
+				mResource->deallocate(mSets[0], sizeof(MasterSet), std::max<size_t>(alignof(MasterSet), 64));
+				mResource->deallocate(mAccs[0], sizeof(Accumulator), std::max<size_t>(alignof(Accumulator), 64));
+				for (int t = 1; t < THREADS; ++t)
+				{
+					mResource->deallocate(mSets[t], sizeof(SlaveSet), std::max<size_t>(alignof(SlaveSet), 64));
+					mResource->deallocate(mAccs[t], sizeof(Accumulator), std::max<size_t>(alignof(Accumulator), 64));
+				}
+			}
+
+			SharedData& Shared() { return mShared; }
+
+			// Fold steps reduce along a fixed tree over batches instead of thread by thread, so the result
+			// does not change with THREADS. FoldAcc/FoldMulti/FoldAsync partials live per thread and are not affected.
+			// Not with Incremental().
+			void Deterministic(bool on)
+			{
+				if (on && mIncremental)
+					throw std::logic_error("Dispatcher::Deterministic: not in Incremental mode");
+				mDeterministic = on;
+			}
+
+			// Every Fold/FoldAcc/FoldMulti result is also combined with the matching step of the other
+			// processes in the group (after the in-process merge, before finish). nullptr detaches.
+			// Partials must be trivially copyable, see ReduceAcross; algorithms with one that is not are refused here.
+			void Group(ReduceGroup* group)
+			{
+				if (group && !GroupSteps(Steps{}))
+					throw std::invalid_argument("Dispatcher::Group: a Fold partial is not trivially copyable and cannot be sent to other processes");
+				mGroup = group;
+			}
+
+			// Unroll factor (1, 2, 4 or 8) of the AVX-512 loops run by this Dispatcher's Algorithm, set on its
+			// threads for the length of each Run() and restored afterwards; 0 keeps each thread's own avx512::unroll.
+			void Unroll(int factor)
+			{
+				if (factor != 0 && factor != 1 && factor != 2 && factor != 4 && factor != 8)
+					throw std::invalid_argument("Dispatcher::Unroll: factor must be 0, 1, 2, 4 or 8");
+				mUnroll = factor;
+			}
+
+			int Unroll() const { return mUnroll; }
+
+			std::pmr::memory_resource* Resource() { return mResource; }
+
+			static constexpr int threads = THREADS;
+
+			// t == 0 runs on the calling thread, slaves are started on the first call and reused afterwards.
+			// If master throws, the slaves are still waited for before the exception leaves Launch.
+			template<class M> void Launch(Job job, void* ctx, const M& master)
+			{
+				if (workers.empty())
+				{
+					for (int t = 1; t < THREADS; ++t)
+					{
+						workers.emplace_back(&Dispatcher::RunPool, this, t);
+					}
+				}
+
+				{
+					std::lock_guard<std::mutex> l(m_run);
+					mJob = job;
+					mJobCtx = ctx;
+					mRunning = THREADS - 1;
+					++mGeneration;
+				}
+				cv_run.notify_all();
+
+				std::exception_ptr error;
+				try
+				{
+					master();
+				}
+				catch (...)
+				{
+					error = std::current_exception();
+				}
+
+				std::unique_lock<std::mutex> l(m_run);
+				while (mRunning > 0)
+					cv_done.wait(l);
+				if (error)
+					std::rethrow_exception(error);
+			}
+
+			// Run() ends at a Vote step's exit_step once budget has passed since it started, zero for no limit
+			void Budget(std::chrono::steady_clock::duration budget) { mBudget = budget; }
+
+			// from any thread: the running Run() ends at its next Vote step's exit_step; called between Runs,
+			// it applies to the next one
+			void Cancel() { mCancel.store(true, std::memory_order_relaxed); }
+
+			// whether the last Run() left a Vote step because of the budget or Cancel() rather than convergence
+			bool Expired() const { return mExpired; }
+
+			// Incremental mode: instances outlive Run(). The first Run() (and the first after MarkAll()) runs every batch
+			// and records the steps taken; later Runs replay those steps only on the batches marked dirty since the last
+			// Run(), so the path through the steps must not depend on the data. Fold steps keep every batch's partial
+			// and update the result with the dirty ones, by uncombine/combine when the monoid has uncombine
+			// (float sums drift, MarkAll() now and then recomputes them). Not with Deterministic().
+			// Only for algorithms made of Parallel (int or Fold), Separate and Singlethreaded steps.
+			void Incremental(bool on)
+			{
+				if (on == mIncremental)
+					return;
+				if (on)
+				{
+					if (mDeterministic)
+						throw std::logic_error("Dispatcher::Incremental: not with Deterministic()");
+					if (!IncrementalSteps(Steps{}))
+						throw std::invalid_argument("Dispatcher::Incremental: only Parallel (int or Fold), Separate and Singlethreaded steps");
+					mDirty.assign((Z/RO + 63) / 64, 0);
+					mTrace.clear();
+					CreateFoldCache(Steps{});
+				}
+				else
+				{
+					ReleaseKept();
+					DestroyFoldCache(Steps{});
+				}
+				mIncremental = on;
+			}
+
+			// batch b holds elements [b*RO, (b + 1)*RO). Outside Incremental mode every Run() does every batch,
+			// marks are ignored.
+			void MarkDirty(int batch)
+			{
+				if (batch < 0 || batch >= Z/RO)
+					throw std::out_of_range("Dispatcher::MarkDirty: batch outside [0, Z/RO)");
+				if (mIncremental)
+					mDirty[batch >> 6] |= uint64_t(1) << (batch & 63);
+			}
+
+			void MarkDirtyElements(int first, int count)
+			{
+				for (int b = first / RO; b <= (first + count - 1) / RO && count > 0; ++b)
+					MarkDirty(b);
+			}
+
+			void MarkAll() { mAllDirty = true; }
+
+			// a step that throws terminates the process, on the calling thread as on the others:
+			// the remaining threads would be left waiting in the barrier
+			void Run()
+			{
+				if (mIncremental)
+				{
+					mPriming = !mKept || mAllDirty;
+					if (mPriming)
+					{
+						ReleaseKept();
+						mTrace.clear();
+					}
+				}
+				for (auto& slot : mVotes)
+				{
+					slot.issued.fill(0);
+					slot.words[0].store(0, std::memory_order_relaxed);
+					slot.words[1].store(0, std::memory_order_relaxed);
+				}
+				mExpired = false;
+				mDeadline = std::chrono::steady_clock::now() + mBudget;
+				Launch([](void* d, int t)
+				{
+					auto self = static_cast<Dispatcher*>(d);
+					UnrollScope unroll(self->mUnroll);
+					self->RunWorkerS(t);
+				}, this, [this]() noexcept
+				{
+					UnrollScope unroll(mUnroll);
+					RunWorkerM(0);
+				});
+				// cleared once the Run is over, so a Cancel() from before or during start-up is not lost
+				mCancel.store(false, std::memory_order_relaxed);
+				if (mIncremental)
+				{
+					mKept = true;
+					mAllDirty = false;
+					std::fill(mDirty.begin(), mDirty.end(), 0);
+				}
+			}
+
+			// runs job(t) for every t in [0, THREADS) on the Dispatcher's threads, outside of any Algorithm.
+			// An exception from job(0) is rethrown once the other threads are done; one from a slave terminates.
+			template<class F> void Parallel(const F& job)
+			{
+				Launch([](void* f, int t) { (*static_cast<const F*>(f))(t); }, const_cast<F*>(&job), [&job]() { job(0); });
 			}
 		};
 	}
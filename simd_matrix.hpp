@@ -0,0 +1,352 @@
+#pragma once
+#include "simd_array_avx512.hpp"
+#include "simd_view.hpp"
+
+#include <immintrin.h>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+#include <type_traits>
+
+namespace simd
+{
+	// Row-major window into a matrix; stride is the distance between rows in elements.
+	template<class Scalar> struct MatrixRef
+	{
+		Scalar* data;
+		int rows;
+		int cols;
+		int stride;
+
+		MatrixRef(Scalar* d, int r, int c, int s) : data(d), rows(r), cols(c), stride(s) {}
+
+		template<class S, class = std::enable_if_t<std::is_same<const S, Scalar>::value>>
+		MatrixRef(const MatrixRef<S>& rhs) : data(rhs.data), rows(rhs.rows), cols(rhs.cols), stride(rhs.stride) {}
+
+		Scalar* operator[](int r) const { return data + r*stride; }
+
+		MatrixRef block(int r, int c, int nr, int nc) const { return MatrixRef(data + r*stride + c, nr, nc, stride); }
+
+		// zero-copy slices, for non-const Scalar
+		ArrayViewAVX512<Scalar> row(int r) const { return ArrayViewAVX512<Scalar>(data + r*stride, cols); }
+		StridedView<Scalar> col(int c) const { return StridedView<Scalar>(data + c, rows, stride); }
+	};
+
+	// R == C == 0 is the runtime-sized matrix, like ValArrayAVX512<..., 0> for vectors
+	template<class Scalar, int R = 0, int C = 0> class alignas(64) AlignedMatrix
+	{
+		static_assert((C * sizeof(Scalar)) % 64 == 0, "AlignedMatrix rows must be whole AVX-512 registers");
+
+		AlignedArrayAVX512<Scalar, C> data[R];
+	public:
+		using ScalarType = Scalar;
+
+		int rows() const { return R; }
+		int cols() const { return C; }
+
+		AlignedArrayAVX512<Scalar, C>& operator[](int r) { return data[r]; }
+		const AlignedArrayAVX512<Scalar, C>& operator[](int r) const { return data[r]; }
+
+		MatrixRef<Scalar> ref() { return MatrixRef<Scalar>(data[0].begin(), R, C, C); }
+		MatrixRef<const Scalar> ref() const { return MatrixRef<const Scalar>(data[0].begin(), R, C, C); }
+	};
+
+	template<class Scalar> class AlignedMatrix<Scalar, 0, 0>
+	{
+		int R;
+		int C;
+		int stride;
+		AlignedVectorAVX512<Scalar> data;
+
+		static int padded(int cols) { const int L = 64 / sizeof(Scalar); return (cols + L - 1) / L * L; }
+	public:
+		using ScalarType = Scalar;
+
+		AlignedMatrix(int rows, int cols, std::pmr::memory_resource* res = std::pmr::get_default_resource())
+			: R(rows), C(cols), stride(padded(cols)), data(rows * padded(cols), res)
+		{
+			data = Scalar{};
+		}
+
+		int rows() const { return R; }
+		int cols() const { return C; }
+
+		Scalar* operator[](int r) { return data.begin() + r*stride; }
+		const Scalar* operator[](int r) const { return data.begin() + r*stride; }
+
+		MatrixRef<Scalar> ref() { return MatrixRef<Scalar>(data.begin(), R, C, stride); }
+		MatrixRef<const Scalar> ref() const { return MatrixRef<const Scalar>(data.begin(), R, C, stride); }
+	};
+
+	namespace detail
+	{
+		template<class Scalar> struct GemmKernel
+		{
+			using V = typename avx512::Value<Scalar>::Type;
+
+			static constexpr int L  = 64 / sizeof(Scalar);
+			static constexpr int MR = 12;			// 2*MR accumulators + 2 B registers + 1 broadcast out of 32 zmm
+			static constexpr int NR = 2 * L;
+			static constexpr int KC = 256;			// MR x KC sliver of A and KC x NR sliver of B stay in L1
+			static constexpr int MC = MR * 10;		// packed A block stays in L2
+			static constexpr int NC = NR * 64;		// packed B panel stays in L3
+
+			static V masked_load(const Scalar* p, int n);
+			static Scalar reduce(V v);
+
+			static void pack_a(MatrixRef<const Scalar> A, int i0, int mc, int p0, int kc, Scalar* buf)
+			{
+				for (int ir = 0; ir < mc; ir += MR)
+				{
+					Scalar* dst = buf + ir * kc;
+					const int mr = std::min(MR, mc - ir);
+					for (int p = 0; p < kc; ++p)
+					{
+						for (int i = 0; i < MR; ++i)
+							dst[p*MR + i] = (i < mr) ? A[i0 + ir + i][p0 + p] : Scalar{};
+					}
+				}
+			}
+
+			static void pack_b(MatrixRef<const Scalar> B, int p0, int kc, int j0, int nc, Scalar* buf)
+			{
+				for (int jr = 0; jr < nc; jr += NR)
+				{
+					Scalar* dst = buf + jr * kc;
+					const int nr = std::min(NR, nc - jr);
+					for (int p = 0; p < kc; ++p)
+					{
+						const Scalar* src = B[p0 + p] + j0 + jr;
+						if (nr == NR)
+						{
+							std::memcpy(dst + p*NR, src, NR * sizeof(Scalar));
+						}
+						else
+						{
+							for (int j = 0; j < NR; ++j)
+								dst[p*NR + j] = (j < nr) ? src[j] : Scalar{};
+						}
+					}
+				}
+			}
+
+			template<size_t... I>
+			static void micro(int kc, const Scalar* a, const Scalar* b, Scalar* c, int ldc, bool accumulate, std::index_sequence<I...>)
+			{
+				V c0[MR] = {};
+				V c1[MR] = {};
+				const avx512::fmadd fma;
+
+				for (int p = 0; p < kc; ++p, a += MR, b += NR)
+				{
+					const V b0 = avx512::load_aligned(reinterpret_cast<const V*>(b));
+					const V b1 = avx512::load_aligned(reinterpret_cast<const V*>(b) + 1);
+					((c0[I] = fma(avx512::Value<Scalar>::fill(a[I]), b0, c0[I]),
+					  c1[I] = fma(avx512::Value<Scalar>::fill(a[I]), b1, c1[I])), ...);
+				}
+
+				if (accumulate)
+				{
+					const avx512::plus add;
+					((avx512::store(reinterpret_cast<V*>(c + I*ldc), add(avx512::load(reinterpret_cast<const V*>(c + I*ldc)), c0[I])),
+					  avx512::store(reinterpret_cast<V*>(c + I*ldc) + 1, add(avx512::load(reinterpret_cast<const V*>(c + I*ldc) + 1), c1[I]))), ...);
+				}
+				else
+				{
+					((avx512::store(reinterpret_cast<V*>(c + I*ldc), c0[I]),
+					  avx512::store(reinterpret_cast<V*>(c + I*ldc) + 1, c1[I])), ...);
+				}
+			}
+
+			// full tiles go straight to C, edge tiles through a scratch tile
+			static void tile(int kc, const Scalar* a, const Scalar* b, Scalar* c, int ldc, bool accumulate, int mr, int nr)
+			{
+				if (mr == MR && nr == NR)
+				{
+					micro(kc, a, b, c, ldc, accumulate, std::make_index_sequence<MR>{});
+					return;
+				}
+
+				alignas(64) Scalar scratch[MR * NR];
+				micro(kc, a, b, scratch, NR, false, std::make_index_sequence<MR>{});
+				for (int i = 0; i < mr; ++i)
+				{
+					for (int j = 0; j < nr; ++j)
+						c[i*ldc + j] = accumulate ? c[i*ldc + j] + scratch[i*NR + j] : scratch[i*NR + j];
+				}
+			}
+
+			static void gemm(MatrixRef<const Scalar> A, MatrixRef<const Scalar> B, MatrixRef<Scalar> C, bool accumulate)
+			{
+				const int M = C.rows;
+				const int N = C.cols;
+				const int K = A.cols;
+
+				if (K == 0)
+				{
+					if (!accumulate)
+					{
+						for (int i = 0; i < M; ++i)
+							std::fill(C[i], C[i] + N, Scalar{});
+					}
+					return;
+				}
+
+				thread_local AlignedVectorAVX512<Scalar> packed_a(MC * KC);
+				thread_local AlignedVectorAVX512<Scalar> packed_b(KC * NC);
+
+				for (int jc = 0; jc < N; jc += NC)
+				{
+					const int nc = std::min(NC, N - jc);
+					for (int pc = 0; pc < K; pc += KC)
+					{
+						const int kc = std::min(KC, K - pc);
+						const bool acc = accumulate || pc > 0;
+						pack_b(B, pc, kc, jc, nc, packed_b.begin());
+
+						for (int ic = 0; ic < M; ic += MC)
+						{
+							const int mc = std::min(MC, M - ic);
+							pack_a(A, ic, mc, pc, kc, packed_a.begin());
+
+							for (int jr = 0; jr < nc; jr += NR)
+							{
+								for (int ir = 0; ir < mc; ir += MR)
+								{
+									tile(kc, packed_a.begin() + ir*kc, packed_b.begin() + jr*kc,
+										C[ic + ir] + jc + jr, C.stride, acc, std::min(MR, mc - ir), std::min(NR, nc - jr));
+								}
+							}
+						}
+					}
+				}
+			}
+
+			// four rows share every load of x, the tail is a masked load
+			static void gemv(MatrixRef<const Scalar> A, const Scalar* x, Scalar* y, bool accumulate)
+			{
+				const int M = A.rows;
+				const int K = A.cols;
+				const int tail = K % L;
+				const avx512::fmadd fma;
+
+				int i = 0;
+				for (; i + 4 <= M; i += 4)
+				{
+					const Scalar* r0 = A[i + 0];
+					const Scalar* r1 = A[i + 1];
+					const Scalar* r2 = A[i + 2];
+					const Scalar* r3 = A[i + 3];
+					V a0{}, a1{}, a2{}, a3{};
+
+					int k = 0;
+					for (; k + L <= K; k += L)
+					{
+						const V xv = avx512::load(reinterpret_cast<const V*>(x + k));
+						a0 = fma(avx512::load(reinterpret_cast<const V*>(r0 + k)), xv, a0);
+						a1 = fma(avx512::load(reinterpret_cast<const V*>(r1 + k)), xv, a1);
+						a2 = fma(avx512::load(reinterpret_cast<const V*>(r2 + k)), xv, a2);
+						a3 = fma(avx512::load(reinterpret_cast<const V*>(r3 + k)), xv, a3);
+					}
+					if (tail)
+					{
+						const V xv = masked_load(x + k, tail);
+						a0 = fma(masked_load(r0 + k, tail), xv, a0);
+						a1 = fma(masked_load(r1 + k, tail), xv, a1);
+						a2 = fma(masked_load(r2 + k, tail), xv, a2);
+						a3 = fma(masked_load(r3 + k, tail), xv, a3);
+					}
+
+					y[i + 0] = (accumulate ? y[i + 0] : Scalar{}) + reduce(a0);
+					y[i + 1] = (accumulate ? y[i + 1] : Scalar{}) + reduce(a1);
+					y[i + 2] = (accumulate ? y[i + 2] : Scalar{}) + reduce(a2);
+					y[i + 3] = (accumulate ? y[i + 3] : Scalar{}) + reduce(a3);
+				}
+
+				for (; i < M; ++i)
+				{
+					const Scalar* r = A[i];
+					V a{};
+					int k = 0;
+					for (; k + L <= K; k += L)
+						a = fma(avx512::load(reinterpret_cast<const V*>(r + k)), avx512::load(reinterpret_cast<const V*>(x + k)), a);
+					if (tail)
+						a = fma(masked_load(r + k, tail), masked_load(x + k, tail), a);
+					y[i] = (accumulate ? y[i] : Scalar{}) + reduce(a);
+				}
+			}
+		};
+
+		template<> inline __m512 GemmKernel<float>::masked_load(const float* p, int n) { return _mm512_maskz_loadu_ps(__mmask16((1u << n) - 1), p); }
+		template<> inline __m512d GemmKernel<double>::masked_load(const double* p, int n) { return _mm512_maskz_loadu_pd(__mmask8((1u << n) - 1), p); }
+		template<> inline float GemmKernel<float>::reduce(__m512 v) { return _mm512_reduce_add_ps(v); }
+		template<> inline double GemmKernel<double>::reduce(__m512d v) { return _mm512_reduce_add_pd(v); }
+
+		// contiguous share [begin, end) of n items for thread t, in multiples of step
+		inline std::pair<int, int> share(int n, int step, int t, int threads)
+		{
+			const int chunks = (n + step - 1) / step;
+			const int b = static_cast<int>(static_cast<long long>(chunks) * t / threads) * step;
+			const int e = static_cast<int>(static_cast<long long>(chunks) * (t + 1) / threads) * step;
+			return { std::min(b, n), std::min(e, n) };
+		}
+	}
+
+	// C = A * B, or C += A * B with accumulate
+	template<class MA, class MB, class MC>
+	void gemm(const MA& a, const MB& b, MC& c, bool accumulate = false)
+	{
+		detail::GemmKernel<typename MC::ScalarType>::gemm(a.ref(), b.ref(), c.ref(), accumulate);
+	}
+
+	// y = A * x, or y += A * x with accumulate; x and y are any containers with begin()
+	template<class MA, class VX, class VY>
+	void gemv(const MA& a, const VX& x, VY& y, bool accumulate = false)
+	{
+		detail::GemmKernel<typename MA::ScalarType>::gemv(a.ref(), x.begin(), y.begin(), accumulate);
+	}
+
+	// Splits C into row blocks (or column blocks when there are too few rows) across the Dispatcher's threads.
+	// Every thread packs its own panels, so there is no synchronization inside the product.
+	template<class Pool, class MA, class MB, class MC>
+	void parallel_gemm(Pool& pool, const MA& a, const MB& b, MC& c, bool accumulate = false)
+	{
+		using Kernel = detail::GemmKernel<typename MC::ScalarType>;
+		auto A = a.ref();
+		auto B = b.ref();
+		auto C = c.ref();
+		const bool by_rows = C.rows >= Pool::threads * Kernel::MR || C.rows >= C.cols;
+
+		pool.Parallel([&](int t)
+		{
+			if (by_rows)
+			{
+				auto r = detail::share(C.rows, Kernel::MR, t, Pool::threads);
+				if (r.first < r.second)
+					Kernel::gemm(A.block(r.first, 0, r.second - r.first, A.cols), B, C.block(r.first, 0, r.second - r.first, C.cols), accumulate);
+			}
+			else
+			{
+				auto r = detail::share(C.cols, Kernel::NR, t, Pool::threads);
+				if (r.first < r.second)
+					Kernel::gemm(A, B.block(0, r.first, B.rows, r.second - r.first), C.block(0, r.first, C.rows, r.second - r.first), accumulate);
+			}
+		});
+	}
+
+	template<class Pool, class MA, class VX, class VY>
+	void parallel_gemv(Pool& pool, const MA& a, const VX& x, VY& y, bool accumulate = false)
+	{
+		using Kernel = detail::GemmKernel<typename MA::ScalarType>;
+		auto A = a.ref();
+		auto xp = x.begin();
+		auto yp = y.begin();
+
+		pool.Parallel([&](int t)
+		{
+			auto r = detail::share(A.rows, 4, t, Pool::threads);
+			if (r.first < r.second)
+				Kernel::gemv(A.block(r.first, 0, r.second - r.first, A.cols), xp, yp + r.first, accumulate);
+		});
+	}
+}
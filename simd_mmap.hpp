@@ -0,0 +1,145 @@
+#pragma once
+#include "simd_array_avx512.hpp"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <new>
+#include <stdexcept>
+#include <system_error>
+
+namespace simd
+{
+	namespace mmap_flags
+	{
+		static const int populate   = 1;	// fault the whole range in up front, read-only so private mappings stay in the page cache
+		static const int huge_pages = 2;	// madvise(MADV_HUGEPAGE)
+		static const int hugetlb    = 4;	// MAP_HUGETLB, falls back to regular pages when the file is not on hugetlbfs
+		static const int write_back = 8;	// MAP_SHARED + PROT_WRITE, stores go to the file; otherwise writes are private copy-on-write
+
+		static const int defaults = populate | huge_pages;
+	}
+
+	namespace detail
+	{
+		// only ever hands mappings back to the kernel, allocation goes through map_file
+		class MappingResource : public std::pmr::memory_resource
+		{
+			void* do_allocate(size_t, size_t) override { throw std::bad_alloc{}; }
+			void do_deallocate(void* p, size_t bytes, size_t) override { ::munmap(p, bytes); }
+			bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+		};
+
+		inline std::pmr::memory_resource* mapping_resource()
+		{
+			static MappingResource res;
+			return &res;
+		}
+
+		struct Mapping
+		{
+			void*  base;
+			size_t head;	// offset of the requested range inside the mapping
+			size_t length;
+		};
+
+		// Maps [offset, offset + bytes) of fd as the mmap_flags say; base is MAP_FAILED with errno set on failure.
+		// MAP_POPULATE on a private writable mapping write-faults every page, i.e. copies the whole range into
+		// anonymous memory: private mappings are populated read-only and made writable afterwards.
+		inline Mapping map_range(int fd, size_t offset, size_t bytes, int flags)
+		{
+			const bool shared = (flags & mmap_flags::write_back) != 0;
+			int prot  = shared ? PROT_READ | PROT_WRITE : PROT_READ;
+			int share = shared ? MAP_SHARED : MAP_PRIVATE;
+			if (flags & mmap_flags::populate)
+				share |= MAP_POPULATE;
+
+			Mapping m{ MAP_FAILED, 0, 0 };
+
+			if (flags & mmap_flags::hugetlb)
+			{
+				const size_t huge_page = size_t(2) << 20;
+				m.head   = offset % huge_page;
+				m.length = m.head + bytes;
+				m.base   = ::mmap(nullptr, m.length, prot, share | MAP_HUGETLB, fd, offset - m.head);
+			}
+
+			if (m.base == MAP_FAILED)
+			{
+				const size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+				m.head   = offset % page;
+				m.length = m.head + bytes;
+				m.base   = ::mmap(nullptr, m.length, prot, share, fd, offset - m.head);
+			}
+
+			if (m.base == MAP_FAILED)
+				return m;
+
+			if (!shared && ::mprotect(m.base, m.length, PROT_READ | PROT_WRITE) != 0)
+			{
+				int err = errno;
+				::munmap(m.base, m.length);
+				errno = err;
+				m.base = MAP_FAILED;
+				return m;
+			}
+
+			if (flags & mmap_flags::huge_pages)
+				::madvise(m.base, m.length, MADV_HUGEPAGE);
+
+			return m;
+		}
+	}
+
+	// Maps count elements of Scalar starting at byte offset of the file at path.
+	// count == 0 maps everything from offset to the end of the file.
+	// Pages are the page cache's, shared with every other process mapping the same file, until they are written:
+	// without write_back a store gives the process its own copy of that page.
+	// offset must be 64-byte aligned, the length need not be a whole number of registers.
+	template<class Scalar> AlignedVectorAVX512<Scalar> map_file(const char* path, int flags = mmap_flags::defaults, size_t offset = 0, size_t count = 0)
+	{
+		if (offset % 64)
+			throw std::invalid_argument("map_file: offset is not 64-byte aligned");
+
+		int fd = ::open(path, (flags & mmap_flags::write_back) ? O_RDWR : O_RDONLY);
+		if (fd < 0)
+			throw std::system_error(errno, std::generic_category(), path);
+
+		struct stat st;
+		if (::fstat(fd, &st) != 0)
+		{
+			int err = errno;
+			::close(fd);
+			throw std::system_error(err, std::generic_category(), path);
+		}
+
+		size_t file_size = static_cast<size_t>(st.st_size);
+		if (count == 0 && offset < file_size)
+			count = (file_size - offset) / sizeof(Scalar);
+
+		size_t bytes = count * sizeof(Scalar);
+		if (bytes == 0 || offset + bytes > file_size || count > size_t(INT32_MAX))
+		{
+			::close(fd);
+			throw std::invalid_argument("map_file: range must be non-empty and inside the file");
+		}
+
+		detail::Mapping m = detail::map_range(fd, offset, bytes, flags);
+		int err = errno;
+		::close(fd);
+		if (m.base == MAP_FAILED)
+			throw std::system_error(err, std::generic_category(), path);
+
+		Scalar* mem = reinterpret_cast<Scalar*>(static_cast<char*>(m.base) + m.head);
+		return AlignedVectorAVX512<Scalar>(mem, static_cast<int>(count), m.base, m.length, detail::mapping_resource());
+	}
+
+	// Wraps memory owned by someone else; nothing is freed when the vector goes away. mem need not be 64-byte aligned.
+	template<class Scalar> AlignedVectorAVX512<Scalar> view_memory(Scalar* mem, int count)
+	{
+		return AlignedVectorAVX512<Scalar>(mem, count);
+	}
+}
@@ -0,0 +1,271 @@
+#pragma once
+#include "simd_array_avx512.hpp"
+
+#include <immintrin.h>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+namespace simd
+{
+	namespace detail
+	{
+		static const uint32_t philox_m0 = 0xD2511F53;
+		static const uint32_t philox_m1 = 0xCD9E8D57;
+		static const uint32_t philox_w0 = 0x9E3779B9;
+		static const uint32_t philox_w1 = 0xBB67AE85;
+
+		// Philox4x32-10 on one counter, the reference the vector path reproduces
+		inline void philox(uint32_t c[4], uint32_t k0, uint32_t k1)
+		{
+			for (int r = 0; r < 10; ++r)
+			{
+				const uint64_t p0 = uint64_t(philox_m0) * c[0];
+				const uint64_t p1 = uint64_t(philox_m1) * c[2];
+				const uint32_t n0 = uint32_t(p1 >> 32) ^ c[1] ^ k0;
+				const uint32_t n2 = uint32_t(p0 >> 32) ^ c[3] ^ k1;
+				c[1] = uint32_t(p1);
+				c[3] = uint32_t(p0);
+				c[0] = n0;
+				c[2] = n2;
+				k0 += philox_w0;
+				k1 += philox_w1;
+			}
+		}
+
+		// 32x32 -> 64 products of all 16 lanes: even lanes via mul_epu32, odd lanes shifted down first
+		inline void mulhilo(__m512i a, __m512i m, __m512i& hi, __m512i& lo)
+		{
+			const __m512i even = _mm512_mul_epu32(a, m);
+			const __m512i odd = _mm512_mul_epu32(_mm512_srli_epi64(a, 32), m);
+			hi = _mm512_mask_blend_epi32(0xAAAA, _mm512_srli_epi64(even, 32), odd);
+			lo = _mm512_mask_blend_epi32(0xAAAA, even, _mm512_slli_epi64(odd, 32));
+		}
+
+		// w[i] lane j is word i of block j; afterwards out[r] lane k is word k % 4 of block 4r + k / 4
+		inline void blocks_to_elements(const __m512i w[4], __m512i out[4])
+		{
+			const __m512i a = _mm512_unpacklo_epi32(w[0], w[1]);
+			const __m512i b = _mm512_unpackhi_epi32(w[0], w[1]);
+			const __m512i c = _mm512_unpacklo_epi32(w[2], w[3]);
+			const __m512i d = _mm512_unpackhi_epi32(w[2], w[3]);
+			// 128-bit lane q of e_i holds block 4q + i
+			const __m512i e0 = _mm512_unpacklo_epi64(a, c);
+			const __m512i e1 = _mm512_unpackhi_epi64(a, c);
+			const __m512i e2 = _mm512_unpacklo_epi64(b, d);
+			const __m512i e3 = _mm512_unpackhi_epi64(b, d);
+			const __m512i f0 = _mm512_shuffle_i32x4(e0, e1, 0x44);
+			const __m512i f1 = _mm512_shuffle_i32x4(e2, e3, 0x44);
+			const __m512i g0 = _mm512_shuffle_i32x4(e0, e1, 0xEE);
+			const __m512i g1 = _mm512_shuffle_i32x4(e2, e3, 0xEE);
+			out[0] = _mm512_shuffle_i32x4(f0, f1, 0x88);
+			out[1] = _mm512_shuffle_i32x4(f0, f1, 0xDD);
+			out[2] = _mm512_shuffle_i32x4(g0, g1, 0x88);
+			out[3] = _mm512_shuffle_i32x4(g0, g1, 0xDD);
+		}
+
+		// [0, 1) from the top 24 bits
+		inline __m512 to_unit(__m512i u)
+		{
+			return _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_srli_epi32(u, 8)), _mm512_set1_ps(1.f / 16777216.f));
+		}
+
+		// (0, 1], safe for log
+		inline __m512 to_unit_open(__m512i u)
+		{
+			return _mm512_mul_ps(_mm512_cvtepi32_ps(_mm512_add_epi32(_mm512_srli_epi32(u, 8), _mm512_set1_epi32(1))), _mm512_set1_ps(1.f / 16777216.f));
+		}
+
+		// natural log for x > 0: x = m 2^k with m in [0.75, 1.5), log(m) = 2 atanh(s), s = (m - 1) / (m + 1)
+		inline __m512 log_ps(__m512 x)
+		{
+			const __m512 k = _mm512_getexp_ps(_mm512_mul_ps(x, _mm512_set1_ps(4.f / 3.f)));
+			const __m512 m = _mm512_scalef_ps(x, _mm512_sub_ps(_mm512_setzero_ps(), k));
+			const __m512 s = _mm512_div_ps(_mm512_sub_ps(m, _mm512_set1_ps(1.f)), _mm512_add_ps(m, _mm512_set1_ps(1.f)));
+			const __m512 s2 = _mm512_mul_ps(s, s);
+			__m512 p = _mm512_set1_ps(2.f / 9);
+			p = _mm512_fmadd_ps(p, s2, _mm512_set1_ps(2.f / 7));
+			p = _mm512_fmadd_ps(p, s2, _mm512_set1_ps(2.f / 5));
+			p = _mm512_fmadd_ps(p, s2, _mm512_set1_ps(2.f / 3));
+			p = _mm512_fmadd_ps(p, s2, _mm512_set1_ps(2.f));
+			return _mm512_fmadd_ps(k, _mm512_set1_ps(0.69314718056f), _mm512_mul_ps(p, s));
+		}
+
+		// sin and cos of 2 pi u for u in [0, 1): quadrant q = round(4u), |2 pi (u - q/4)| <= pi/4
+		inline void sincos_turns(__m512 u, __m512& sin, __m512& cos)
+		{
+			const __m512 q = _mm512_roundscale_ps(_mm512_mul_ps(u, _mm512_set1_ps(4.f)), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+			const __m512 a = _mm512_mul_ps(_mm512_fnmadd_ps(q, _mm512_set1_ps(0.25f), u), _mm512_set1_ps(6.28318530718f));
+			const __m512 a2 = _mm512_mul_ps(a, a);
+
+			__m512 s = _mm512_set1_ps(-1.f / 5040);
+			s = _mm512_fmadd_ps(s, a2, _mm512_set1_ps(1.f / 120));
+			s = _mm512_fmadd_ps(s, a2, _mm512_set1_ps(-1.f / 6));
+			s = _mm512_fmadd_ps(_mm512_mul_ps(s, a2), a, a);
+
+			__m512 c = _mm512_set1_ps(1.f / 40320);
+			c = _mm512_fmadd_ps(c, a2, _mm512_set1_ps(-1.f / 720));
+			c = _mm512_fmadd_ps(c, a2, _mm512_set1_ps(1.f / 24));
+			c = _mm512_fmadd_ps(c, a2, _mm512_set1_ps(-0.5f));
+			c = _mm512_fmadd_ps(c, a2, _mm512_set1_ps(1.f));
+
+			// rotate by q quarter turns
+			const __m512i qi = _mm512_cvtps_epi32(q);
+			const __mmask16 odd = _mm512_test_epi32_mask(qi, _mm512_set1_epi32(1));
+			const __mmask16 neg_s = _mm512_test_epi32_mask(qi, _mm512_set1_epi32(2));
+			const __mmask16 neg_c = _mm512_test_epi32_mask(_mm512_add_epi32(qi, _mm512_set1_epi32(1)), _mm512_set1_epi32(2));
+			const __m512 sin_q = _mm512_mask_blend_ps(odd, s, c);
+			const __m512 cos_q = _mm512_mask_blend_ps(odd, c, s);
+			const __m512 sign = _mm512_set1_ps(-0.f);
+			sin = _mm512_mask_xor_ps(sin_q, neg_s, sin_q, sign);
+			cos = _mm512_mask_xor_ps(cos_q, neg_c, cos_q, sign);
+		}
+	}
+
+	// Counter-based generator, Philox4x32-10. Word e % 4 of the block e / 4 of draw d is element e's value, so every
+	// sample is a pure function of (seed, stream, draw, global element index) and does not depend on THREADS, RO
+	// or the order batches run in. Key fills by the batch's global offset, offset_global - offset_local of
+	// Step_Separate, and use a new draw for every round of samples an element needs.
+	class Philox
+	{
+		uint32_t k0;
+		uint32_t k1;
+		uint32_t stream;
+
+		// 64 raw words, elements 4b .. 4b + 63 in order
+		void Chunk(uint64_t b, uint32_t draw, __m512i out[4]) const
+		{
+			__m512i w[4];
+			Blocks(b, draw, w);
+			detail::blocks_to_elements(w, out);
+		}
+
+		// lane j of w[i] is word i of block b + j
+		void Blocks(uint64_t b, uint32_t draw, __m512i w[4]) const
+		{
+			const __m512i lanes = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+			const __m512i base = _mm512_set1_epi32(int(uint32_t(b)));
+			__m512i c0 = _mm512_add_epi32(base, lanes);
+			// carry into the high word where the low word wrapped
+			__m512i c1 = _mm512_mask_add_epi32(_mm512_set1_epi32(int(uint32_t(b >> 32))), _mm512_cmplt_epu32_mask(c0, base),
+				_mm512_set1_epi32(int(uint32_t(b >> 32))), _mm512_set1_epi32(1));
+			__m512i c2 = _mm512_set1_epi32(int(draw));
+			__m512i c3 = _mm512_set1_epi32(int(stream));
+
+			const __m512i m0 = _mm512_set1_epi32(int(detail::philox_m0));
+			const __m512i m1 = _mm512_set1_epi32(int(detail::philox_m1));
+			uint32_t key0 = k0, key1 = k1;
+			for (int r = 0; r < 10; ++r)
+			{
+				__m512i hi0, lo0, hi1, lo1;
+				detail::mulhilo(c0, m0, hi0, lo0);
+				detail::mulhilo(c2, m1, hi1, lo1);
+				c0 = _mm512_ternarylogic_epi32(hi1, c1, _mm512_set1_epi32(int(key0)), 0x96);
+				c2 = _mm512_ternarylogic_epi32(hi0, c3, _mm512_set1_epi32(int(key1)), 0x96);
+				c1 = lo1;
+				c3 = lo0;
+				key0 += detail::philox_w0;
+				key1 += detail::philox_w1;
+			}
+			w[0] = c0;
+			w[1] = c1;
+			w[2] = c2;
+			w[3] = c3;
+		}
+
+		// Calls make(block, out[4]) for each run of 64 elements covering [offset, offset + n) and writes them out,
+		// through a bounce buffer where the run is cut by the range
+		template<class T, class Make> static void Fill(T* out, int n, uint64_t offset, const Make& make)
+		{
+			static_assert(sizeof(T) == 4, "32-bit outputs");
+			int i = 0;
+			while (i < n)
+			{
+				const uint64_t e = offset + uint64_t(i);
+				const int skip = int(e % 4);
+				__m512i v[4];
+				make(e / 4, v);
+				if (skip == 0 && n - i >= 64)
+				{
+					for (int r = 0; r < 4; ++r)
+						_mm512_storeu_si512(out + i + 16 * r, v[r]);
+					i += 64;
+				}
+				else
+				{
+					alignas(64) T tmp[64];
+					for (int r = 0; r < 4; ++r)
+						_mm512_store_si512(tmp + 16 * r, v[r]);
+					const int take = std::min(64 - skip, n - i);
+					std::copy(tmp + skip, tmp + skip + take, out + i);
+					i += take;
+				}
+			}
+		}
+
+	public:
+		explicit Philox(uint64_t seed, uint32_t stream_id = 0)
+			: k0(uint32_t(seed)), k1(uint32_t(seed >> 32)), stream(stream_id)
+		{
+		}
+
+		// raw 32-bit words of elements [offset, offset + n)
+		void bits(uint32_t* out, int n, uint64_t offset, uint32_t draw = 0) const
+		{
+			Fill(out, n, offset, [&](uint64_t b, __m512i v[4]) { Chunk(b, draw, v); });
+		}
+
+		// uniform in [0, 1), 24 random bits
+		void uniform(float* out, int n, uint64_t offset, uint32_t draw = 0) const
+		{
+			Fill(out, n, offset, [&](uint64_t b, __m512i v[4])
+			{
+				Chunk(b, draw, v);
+				for (int r = 0; r < 4; ++r)
+					v[r] = _mm512_castps_si512(detail::to_unit(v[r]));
+			});
+		}
+
+		// standard normal by Box-Muller: elements 2m and 2m + 1 share words 2m and 2m + 1 as radius and angle
+		void normal(float* out, int n, uint64_t offset, uint32_t draw = 0) const
+		{
+			Fill(out, n, offset, [&](uint64_t b, __m512i v[4])
+			{
+				__m512i w[4];
+				Blocks(b, draw, w);
+				for (int p = 0; p < 4; p += 2)
+				{
+					const __m512 radius = _mm512_sqrt_ps(_mm512_mul_ps(_mm512_set1_ps(-2.f), detail::log_ps(detail::to_unit_open(w[p]))));
+					__m512 s, c;
+					detail::sincos_turns(detail::to_unit(w[p + 1]), s, c);
+					w[p] = _mm512_castps_si512(_mm512_mul_ps(radius, c));
+					w[p + 1] = _mm512_castps_si512(_mm512_mul_ps(radius, s));
+				}
+				detail::blocks_to_elements(w, v);
+			});
+		}
+
+		template<class Array> void uniform(Array& a, uint64_t offset, uint32_t draw = 0) const
+		{
+			uniform(&*a.begin(), int(a.end() - a.begin()), offset, draw);
+		}
+
+		template<class Array> void normal(Array& a, uint64_t offset, uint32_t draw = 0) const
+		{
+			normal(&*a.begin(), int(a.end() - a.begin()), offset, draw);
+		}
+
+		// one element's raw word, same value the fills produce
+		uint32_t bits_at(uint64_t element, uint32_t draw = 0) const
+		{
+			uint32_t c[4] = { uint32_t(element / 4), uint32_t(element / 4 >> 32), draw, stream };
+			detail::philox(c, k0, k1);
+			return c[element % 4];
+		}
+
+		float uniform_at(uint64_t element, uint32_t draw = 0) const
+		{
+			return float(bits_at(element, draw) >> 8) * (1.f / 16777216.f);
+		}
+	};
+}
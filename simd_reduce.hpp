@@ -0,0 +1,455 @@
+#pragma once
+#include "simd.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+#ifdef __AVX512F__
+#include <immintrin.h>
+#endif
+
+// Monoids for Fold<DataBatch, Op>, FoldAcc<DataBatch, Op> and FoldMulti<..., Op>.
+// Every partial works lane by lane on a whole batch, combine() is vectorized with AVX-512 when the
+// target has it, finish() collapses the lanes of the last partial into the result.
+namespace simd
+{
+	namespace monoid
+	{
+		namespace detail
+		{
+			template<class Batch> using scalar_t = typename Batch::ScalarType;
+
+			template<class Batch> int lanes(const Batch& b)
+			{
+				return static_cast<int>(b.end() - b.begin());
+			}
+
+			// index lanes line up with value lanes: 32 bit for float, 64 bit for double
+			template<class Scalar> using index_t = std::conditional_t<sizeof(Scalar) == 8, int64_t, int32_t>;
+
+			template<class Scalar> struct Vec {};
+
+#ifdef __AVX512F__
+			template<> struct Vec<float>
+			{
+				using V = __m512;
+				using M = __mmask16;
+				static const int n = 16;
+
+				static V    load(const float* p) { return _mm512_loadu_ps(p); }
+				static void store(float* p, V v) { _mm512_storeu_ps(p, v); }
+				static V    set1(float x) { return _mm512_set1_ps(x); }
+				static V    add(V a, V b) { return _mm512_add_ps(a, b); }
+				static V    sub(V a, V b) { return _mm512_sub_ps(a, b); }
+				static V    mul(V a, V b) { return _mm512_mul_ps(a, b); }
+				static V    div(V a, V b) { return _mm512_div_ps(a, b); }
+				static V    fma(V a, V b, V c) { return _mm512_fmadd_ps(a, b, c); }
+				static V    min(V a, V b) { return _mm512_min_ps(a, b); }
+				static V    max(V a, V b) { return _mm512_max_ps(a, b); }
+				static M    gt(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+				static M    lt(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+				static M    eq(V a, V b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+				static V    blend(M m, V a, V b) { return _mm512_mask_blend_ps(m, a, b); }
+
+				static M index_lt(const int32_t* a, const int32_t* b) { return _mm512_cmplt_epi32_mask(_mm512_loadu_si512(a), _mm512_loadu_si512(b)); }
+
+				static void blend_index(M m, int32_t* l, const int32_t* r)
+				{
+					__m512i a = _mm512_loadu_si512(l);
+					_mm512_storeu_si512(l, _mm512_mask_blend_epi32(m, a, _mm512_loadu_si512(r)));
+				}
+
+				// 2^(x log2 e) with a degree 6 polynomial on [-ln2/2, ln2/2], then scalef
+				static V exp(V x)
+				{
+					x = _mm512_max_ps(_mm512_min_ps(x, set1(88.7f)), set1(-104.f));
+					V t = _mm512_mul_ps(x, set1(1.44269504089f));
+					V k = _mm512_roundscale_ps(t, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+					V r = _mm512_mul_ps(_mm512_sub_ps(t, k), set1(0.69314718056f));
+					V p = set1(1.f / 720);
+					p = fma(p, r, set1(1.f / 120));
+					p = fma(p, r, set1(1.f / 24));
+					p = fma(p, r, set1(1.f / 6));
+					p = fma(p, r, set1(0.5f));
+					p = fma(p, r, set1(1.f));
+					p = fma(p, r, set1(1.f));
+					return _mm512_scalef_ps(p, k);
+				}
+			};
+
+			template<> struct Vec<double>
+			{
+				using V = __m512d;
+				using M = __mmask8;
+				static const int n = 8;
+
+				static V    load(const double* p) { return _mm512_loadu_pd(p); }
+				static void store(double* p, V v) { _mm512_storeu_pd(p, v); }
+				static V    set1(double x) { return _mm512_set1_pd(x); }
+				static V    add(V a, V b) { return _mm512_add_pd(a, b); }
+				static V    sub(V a, V b) { return _mm512_sub_pd(a, b); }
+				static V    mul(V a, V b) { return _mm512_mul_pd(a, b); }
+				static V    div(V a, V b) { return _mm512_div_pd(a, b); }
+				static V    fma(V a, V b, V c) { return _mm512_fmadd_pd(a, b, c); }
+				static V    min(V a, V b) { return _mm512_min_pd(a, b); }
+				static V    max(V a, V b) { return _mm512_max_pd(a, b); }
+				static M    gt(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+				static M    lt(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+				static M    eq(V a, V b) { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ); }
+				static V    blend(M m, V a, V b) { return _mm512_mask_blend_pd(m, a, b); }
+
+				static M index_lt(const int64_t* a, const int64_t* b) { return _mm512_cmplt_epi64_mask(_mm512_loadu_si512(a), _mm512_loadu_si512(b)); }
+
+				static void blend_index(M m, int64_t* l, const int64_t* r)
+				{
+					__m512i a = _mm512_loadu_si512(l);
+					_mm512_storeu_si512(l, _mm512_mask_blend_epi64(m, a, _mm512_loadu_si512(r)));
+				}
+
+				static V exp(V x)
+				{
+					x = _mm512_max_pd(_mm512_min_pd(x, set1(709.7)), set1(-746.0));
+					V t = _mm512_mul_pd(x, set1(1.4426950408889634));
+					V k = _mm512_roundscale_pd(t, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+					V r = _mm512_mul_pd(_mm512_sub_pd(t, k), set1(0.6931471805599453));
+					V p = set1(1.0 / 479001600);
+					p = fma(p, r, set1(1.0 / 39916800));
+					p = fma(p, r, set1(1.0 / 3628800));
+					p = fma(p, r, set1(1.0 / 362880));
+					p = fma(p, r, set1(1.0 / 40320));
+					p = fma(p, r, set1(1.0 / 5040));
+					p = fma(p, r, set1(1.0 / 720));
+					p = fma(p, r, set1(1.0 / 120));
+					p = fma(p, r, set1(1.0 / 24));
+					p = fma(p, r, set1(1.0 / 6));
+					p = fma(p, r, set1(0.5));
+					p = fma(p, r, set1(1.0));
+					p = fma(p, r, set1(1.0));
+					return _mm512_scalef_pd(p, k);
+				}
+			};
+
+			template<class Scalar, class = void> struct has_vec : std::false_type {};
+			template<class Scalar> struct has_vec<Scalar, std::void_t<decltype(Vec<Scalar>::n)>> : std::true_type {};
+#else
+			template<class Scalar, class = void> struct has_vec : std::false_type {};
+#endif
+		}
+
+		struct product
+		{
+			template<class DataBatch> using Partial = DataBatch;
+			template<class Scalar>    using Result  = Scalar;
+
+			template<class DataBatch> static void combine(DataBatch& lhs, const DataBatch& rhs) { lhs *= rhs; }
+
+			template<class DataBatch, class Scalar> static void finish(const DataBatch& src, Scalar& target)
+			{
+				Scalar res = Scalar(1);
+				for (const Scalar* p = src.begin(); p != src.end(); ++p) res *= *p;
+				target = res;
+			}
+
+			template<class Scalar> static Scalar identity() { return Scalar(1); }
+		};
+
+		struct min
+		{
+			template<class DataBatch> using Partial = DataBatch;
+			template<class Scalar>    using Result  = Scalar;
+
+			template<class DataBatch> static void combine(DataBatch& lhs, const DataBatch& rhs)
+			{
+				using S = detail::scalar_t<DataBatch>;
+				S* l = lhs.begin();
+				const S* r = rhs.begin();
+				const int n = detail::lanes(lhs);
+				int i = 0;
+#ifdef __AVX512F__
+				if constexpr (detail::has_vec<S>::value)
+				{
+					using W = detail::Vec<S>;
+					for (; i + W::n <= n; i += W::n)
+						W::store(l + i, W::min(W::load(l + i), W::load(r + i)));
+				}
+#endif
+				for (; i < n; ++i)
+					l[i] = (r[i] < l[i]) ? r[i] : l[i];
+			}
+
+			template<class DataBatch, class Scalar> static void finish(const DataBatch& src, Scalar& target)
+			{
+				// infinity where there is one, so a batch of +inf gives +inf
+				Scalar res = std::numeric_limits<Scalar>::has_infinity ? std::numeric_limits<Scalar>::infinity() : std::numeric_limits<Scalar>::max();
+				for (const Scalar* p = src.begin(); p != src.end(); ++p) res = (*p < res) ? *p : res;
+				target = res;
+			}
+		};
+
+		struct max
+		{
+			template<class DataBatch> using Partial = DataBatch;
+			template<class Scalar>    using Result  = Scalar;
+
+			template<class DataBatch> static void combine(DataBatch& lhs, const DataBatch& rhs)
+			{
+				using S = detail::scalar_t<DataBatch>;
+				S* l = lhs.begin();
+				const S* r = rhs.begin();
+				const int n = detail::lanes(lhs);
+				int i = 0;
+#ifdef __AVX512F__
+				if constexpr (detail::has_vec<S>::value)
+				{
+					using W = detail::Vec<S>;
+					for (; i + W::n <= n; i += W::n)
+						W::store(l + i, W::max(W::load(l + i), W::load(r + i)));
+				}
+#endif
+				for (; i < n; ++i)
+					l[i] = (r[i] > l[i]) ? r[i] : l[i];
+			}
+
+			template<class DataBatch, class Scalar> static void finish(const DataBatch& src, Scalar& target)
+			{
+				Scalar res = std::numeric_limits<Scalar>::has_infinity ? -std::numeric_limits<Scalar>::infinity() : std::numeric_limits<Scalar>::lowest();
+				for (const Scalar* p = src.begin(); p != src.end(); ++p) res = (*p > res) ? *p : res;
+				target = res;
+			}
+		};
+
+		// Lane j holds the best value seen in that lane and the global element index it came from.
+		// Ties resolve to the smaller index, so the result does not depend on merge order.
+		template<class DataBatch> struct ArgPartial
+		{
+			using Scalar = detail::scalar_t<DataBatch>;
+			using Index  = detail::index_t<Scalar>;
+
+			DataBatch value;
+			alignas(64) Index index[sizeof(DataBatch) / sizeof(Scalar)];
+		};
+
+		template<class Scalar> struct Arg
+		{
+			Scalar  value;
+			int64_t index;
+		};
+
+		template<bool Greater> struct arg_best
+		{
+			template<class DataBatch> using Partial = ArgPartial<DataBatch>;
+			template<class Scalar>    using Result  = Arg<Scalar>;
+
+			template<class Scalar, class Index> static bool better(Scalar rv, Index ri, Scalar lv, Index li)
+			{
+				return Greater ? (rv > lv || (rv == lv && ri < li)) : (rv < lv || (rv == lv && ri < li));
+			}
+
+			template<class DataBatch> static void combine(ArgPartial<DataBatch>& lhs, const ArgPartial<DataBatch>& rhs)
+			{
+				using S = detail::scalar_t<DataBatch>;
+				S* lv = lhs.value.begin();
+				const S* rv = rhs.value.begin();
+				auto* li = lhs.index;
+				const auto* ri = rhs.index;
+
+				const int n = detail::lanes(lhs.value);
+				int i = 0;
+#ifdef __AVX512F__
+				if constexpr (detail::has_vec<S>::value)
+				{
+					using W = detail::Vec<S>;
+					for (; i + W::n <= n; i += W::n)
+					{
+						auto a = W::load(lv + i);
+						auto b = W::load(rv + i);
+						auto m = (Greater ? W::gt(b, a) : W::lt(b, a)) | (W::eq(b, a) & W::index_lt(ri + i, li + i));
+						W::store(lv + i, W::blend(m, a, b));
+						W::blend_index(m, li + i, ri + i);
+					}
+				}
+#endif
+				for (; i < n; ++i)
+				{
+					if (better(rv[i], ri[i], lv[i], li[i]))
+					{
+						lv[i] = rv[i];
+						li[i] = ri[i];
+					}
+				}
+			}
+
+			template<class DataBatch, class Scalar> static void finish(const ArgPartial<DataBatch>& src, Arg<Scalar>& target)
+			{
+				const int n = detail::lanes(src.value);
+				const Scalar* v = src.value.begin();
+				int best = 0;
+				for (int i = 1; i < n; ++i)
+				{
+					if (better(v[i], src.index[i], v[best], src.index[best]))
+						best = i;
+				}
+				target.value = v[best];
+				target.index = src.index[best];
+			}
+		};
+
+		using argmax = arg_best<true>;
+		using argmin = arg_best<false>;
+
+		// Lane j holds (m, s) with log(sum exp(x)) = m + log(s); start a lane from x as (x, 1)
+		// and an empty lane as (-inf, 0).
+		template<class DataBatch> struct LogSumExpPartial
+		{
+			DataBatch max;
+			DataBatch sum;
+		};
+
+		struct logsumexp
+		{
+			template<class DataBatch> using Partial = LogSumExpPartial<DataBatch>;
+			template<class Scalar>    using Result  = Scalar;
+
+			template<class DataBatch> static void combine(LogSumExpPartial<DataBatch>& lhs, const LogSumExpPartial<DataBatch>& rhs)
+			{
+				using S = detail::scalar_t<DataBatch>;
+				S* lm = lhs.max.begin();
+				S* ls = lhs.sum.begin();
+				const S* rm = rhs.max.begin();
+				const S* rs = rhs.sum.begin();
+
+				// the side that holds the max is scaled by exactly 1, which also keeps -inf lanes finite
+				const int n = detail::lanes(lhs.max);
+				int i = 0;
+#ifdef __AVX512F__
+				if constexpr (detail::has_vec<S>::value)
+				{
+					using W = detail::Vec<S>;
+					for (; i + W::n <= n; i += W::n)
+					{
+						auto a = W::load(lm + i);
+						auto b = W::load(rm + i);
+						auto m = W::max(a, b);
+						auto fa = W::blend(W::eq(a, m), W::exp(W::sub(a, m)), W::set1(S(1)));
+						auto fb = W::blend(W::eq(b, m), W::exp(W::sub(b, m)), W::set1(S(1)));
+						W::store(ls + i, W::fma(W::load(ls + i), fa, W::mul(W::load(rs + i), fb)));
+						W::store(lm + i, m);
+					}
+				}
+#endif
+				for (; i < n; ++i)
+				{
+					S m = (rm[i] > lm[i]) ? rm[i] : lm[i];
+					S fa = (lm[i] == m) ? S(1) : std::exp(lm[i] - m);
+					S fb = (rm[i] == m) ? S(1) : std::exp(rm[i] - m);
+					ls[i] = ls[i] * fa + rs[i] * fb;
+					lm[i] = m;
+				}
+			}
+
+			template<class DataBatch, class Scalar> static void finish(const LogSumExpPartial<DataBatch>& src, Scalar& target)
+			{
+				const int n = detail::lanes(src.max);
+				const Scalar* m = src.max.begin();
+				const Scalar* s = src.sum.begin();
+
+				Scalar top = -std::numeric_limits<Scalar>::infinity();
+				for (int i = 0; i < n; ++i) top = (m[i] > top) ? m[i] : top;
+				if (top == -std::numeric_limits<Scalar>::infinity())
+				{
+					target = top;
+					return;
+				}
+
+				Scalar total{};
+				for (int i = 0; i < n; ++i) total += s[i] * std::exp(m[i] - top);
+				target = top + std::log(total);
+			}
+		};
+
+		// Per-lane count, mean and sum of squared deviations, merged with Chan et al.'s pairwise update.
+		// Start a lane from x as (1, x, 0) and an empty lane as (0, 0, 0).
+		template<class DataBatch> struct WelfordPartial
+		{
+			DataBatch count;
+			DataBatch mean;
+			DataBatch m2;
+		};
+
+		template<class Scalar> struct Moments
+		{
+			Scalar count;
+			Scalar mean;
+			Scalar m2;
+			Scalar variance;	// population variance, m2 / count
+		};
+
+		struct welford
+		{
+			template<class DataBatch> using Partial = WelfordPartial<DataBatch>;
+			template<class Scalar>    using Result  = Moments<Scalar>;
+
+			template<class Scalar> static void merge(Scalar& na, Scalar& ma, Scalar& qa, Scalar nb, Scalar mb, Scalar qb)
+			{
+				Scalar n = na + nb;
+				if (n == Scalar(0))
+					return;
+				Scalar delta = mb - ma;
+				Scalar w = nb / n;
+				ma = ma + delta * w;
+				qa = qa + qb + delta * delta * na * w;
+				na = n;
+			}
+
+			template<class DataBatch> static void combine(WelfordPartial<DataBatch>& lhs, const WelfordPartial<DataBatch>& rhs)
+			{
+				using S = detail::scalar_t<DataBatch>;
+				S* ln = lhs.count.begin();
+				S* lm = lhs.mean.begin();
+				S* lq = lhs.m2.begin();
+				const S* rn = rhs.count.begin();
+				const S* rm = rhs.mean.begin();
+				const S* rq = rhs.m2.begin();
+
+				const int n = detail::lanes(lhs.count);
+				int i = 0;
+#ifdef __AVX512F__
+				if constexpr (detail::has_vec<S>::value)
+				{
+					using W = detail::Vec<S>;
+					for (; i + W::n <= n; i += W::n)
+					{
+						auto na = W::load(ln + i);
+						auto nb = W::load(rn + i);
+						auto ma = W::load(lm + i);
+						auto nn = W::add(na, nb);
+						auto delta = W::sub(W::load(rm + i), ma);
+						// lanes empty on both sides would divide by zero, their weight stays 0
+						auto w  = W::blend(W::eq(nn, W::set1(S(0))), W::div(nb, nn), W::set1(S(0)));
+						W::store(lm + i, W::fma(delta, w, ma));
+						W::store(lq + i, W::add(W::add(W::load(lq + i), W::load(rq + i)), W::mul(W::mul(delta, delta), W::mul(na, w))));
+						W::store(ln + i, nn);
+					}
+				}
+#endif
+				for (; i < n; ++i)
+					merge(ln[i], lm[i], lq[i], rn[i], rm[i], rq[i]);
+			}
+
+			template<class DataBatch, class Scalar> static void finish(const WelfordPartial<DataBatch>& src, Moments<Scalar>& target)
+			{
+				const int n = detail::lanes(src.count);
+				Scalar c{}, m{}, q{};
+				for (int i = 0; i < n; ++i)
+					merge(c, m, q, src.count.begin()[i], src.mean.begin()[i], src.m2.begin()[i]);
+
+				target.count = c;
+				target.mean = m;
+				target.m2 = q;
+				target.variance = (c > Scalar(0)) ? q / c : Scalar(0);
+			}
+		};
+	}
+}
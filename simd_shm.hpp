@@ -0,0 +1,432 @@
+#pragma once
+#include "simd.hpp"
+
+#include <immintrin.h>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace simd
+{
+	namespace shm
+	{
+		namespace detail
+		{
+			static const uint64_t magic = 0x73696d6473686d31ull; // "simdshm1"
+
+			[[noreturn]] inline void fail(const char* what)
+			{
+				throw std::system_error(errno, std::generic_category(), what);
+			}
+
+			// spins briefly, then gives the core away; peers are other processes and may be descheduled
+			template<class Ready> void wait_until(const Ready& ready)
+			{
+				for (int spin = 0; !ready(); ++spin)
+				{
+					if (spin < 1024)
+						_mm_pause();
+					else
+						std::this_thread::yield();
+				}
+			}
+
+			struct Header
+			{
+				std::atomic<uint64_t> magic;
+				int      ranks;
+				int      slots;
+				size_t   slot_bytes;
+				alignas(64) std::atomic<int> attached;
+				alignas(64) std::atomic<int> arrived;
+				std::atomic<int> sense;
+			};
+
+			// single producer / single consumer, counters only grow; slot i lives at data + (i % slots) * slot_bytes
+			struct Ring
+			{
+				alignas(64) std::atomic<uint64_t> head;
+				alignas(64) std::atomic<uint64_t> tail;
+			};
+
+			static_assert(std::atomic<uint64_t>::is_always_lock_free, "rings must be address-free across processes");
+		}
+
+		// Collectives between processes on one host, over a POSIX shared memory segment.
+		// Every ordered pair of ranks gets a lock-free ring of fixed size slots; messages larger than a ring
+		// are streamed through it while the opposite direction is drained, so exchanges never deadlock.
+		// All ranks open the same name (unique per job), rank 0 creates it and unlinks it on destruction.
+		// A Communicator is used by one thread per process, in practice the Dispatcher master.
+		class Communicator : public ReduceGroup
+		{
+		public:
+			// messages up to this size use recursive doubling, longer ones reduce-scatter + allgather
+			size_t small_bytes = size_t(64) << 10;
+
+			Communicator(const std::string& name, int rank, int ranks, size_t slot_bytes = size_t(64) << 10, int slots = 4)
+				: mName(name), mRank(rank), mRanks(ranks)
+			{
+				if (ranks < 1 || rank < 0 || rank >= ranks || slots < 1 || slot_bytes % 64)
+					throw std::invalid_argument("shm::Communicator: bad rank/size");
+
+				const size_t rings = sizeof(detail::Ring) * ranks * ranks;
+				mData  = (sizeof(detail::Header) + rings + 63) & ~size_t(63);
+				mBytes = mData + size_t(ranks) * ranks * slots * slot_bytes;
+
+				int fd;
+				if (rank == 0)
+				{
+					::shm_unlink(name.c_str());
+					fd = ::shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+					if (fd < 0)
+						detail::fail("shm_open");
+					if (::ftruncate(fd, mBytes) != 0)
+					{
+						::close(fd);
+						detail::fail("ftruncate");
+					}
+				}
+				else
+				{
+					// wait for rank 0 to create and size the segment
+					struct stat st{};
+					detail::wait_until([&] { return (fd = ::shm_open(name.c_str(), O_RDWR, 0600)) >= 0 || errno != ENOENT; });
+					if (fd < 0)
+						detail::fail("shm_open");
+					detail::wait_until([&] { return ::fstat(fd, &st) == 0 && size_t(st.st_size) >= mBytes; });
+				}
+
+				void* p = ::mmap(nullptr, mBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+				::close(fd);
+				if (p == MAP_FAILED)
+					detail::fail("mmap");
+
+				mBase = static_cast<char*>(p);
+				mHeader = reinterpret_cast<detail::Header*>(mBase);
+				mRings = reinterpret_cast<detail::Ring*>(mBase + sizeof(detail::Header));
+
+				if (rank == 0)
+				{
+					// ftruncate zero-fills, so the atomics start at 0; publish the layout last
+					mHeader->ranks = ranks;
+					mHeader->slots = slots;
+					mHeader->slot_bytes = slot_bytes;
+					mHeader->magic.store(detail::magic, std::memory_order_release);
+				}
+				else
+				{
+					detail::wait_until([&] { return mHeader->magic.load(std::memory_order_acquire) == detail::magic; });
+					if (mHeader->ranks != ranks || mHeader->slots != slots || mHeader->slot_bytes != slot_bytes)
+					{
+						::munmap(mBase, mBytes);
+						throw std::invalid_argument("shm::Communicator: segment layout mismatch");
+					}
+				}
+
+				mSlots = slots;
+				mSlotBytes = slot_bytes;
+
+				mHeader->attached.fetch_add(1, std::memory_order_acq_rel);
+				detail::wait_until([&] { return mHeader->attached.load(std::memory_order_acquire) == ranks; });
+			}
+
+			Communicator(const Communicator&) = delete;
+			Communicator& operator=(const Communicator&) = delete;
+
+			~Communicator()
+			{
+				::munmap(mBase, mBytes);
+				if (mRank == 0)
+					::shm_unlink(mName.c_str());
+			}
+
+			int rank() const { return mRank; }
+			int size() const { return mRanks; }
+
+			void barrier()
+			{
+				const int sense = 1 - mSense;
+				mSense = sense;
+				if (mHeader->arrived.fetch_add(1, std::memory_order_acq_rel) == mRanks - 1)
+				{
+					mHeader->arrived.store(0, std::memory_order_relaxed);
+					mHeader->sense.store(sense, std::memory_order_release);
+				}
+				else
+				{
+					detail::wait_until([&] { return mHeader->sense.load(std::memory_order_acquire) == sense; });
+				}
+			}
+
+			// Copies bytes from root to every rank along a binomial tree.
+			void broadcast(void* data, size_t bytes, int root = 0)
+			{
+				const int rel = (mRank - root + mRanks) % mRanks;
+
+				int mask = 1;
+				while (mask < mRanks)
+				{
+					if (rel & mask)
+					{
+						const int src = (rel - mask + root) % mRanks;
+						exchange(-1, nullptr, 0, src, data, bytes);
+						break;
+					}
+					mask <<= 1;
+				}
+
+				for (mask >>= 1; mask > 0; mask >>= 1)
+				{
+					if (rel + mask < mRanks)
+					{
+						const int dst = (rel + mask + root) % mRanks;
+						exchange(dst, data, bytes, -1, nullptr, 0);
+					}
+				}
+			}
+
+			// items[i] = combine over all ranks of items[i], with combine(T& lhs, const T& rhs) folding rhs into lhs.
+			// Every element is reduced on one rank and copied to the rest, so all ranks get bitwise identical results;
+			// the order of operands depends on the algorithm, so combine should be commutative up to rounding.
+			template<class T, class F> void allreduce(T* items, size_t count, const F& combine)
+			{
+				static_assert(std::is_trivially_copyable<T>::value, "allreduce moves raw bytes between processes");
+				auto fn = [](const void* ctx, void* lhs, const void* rhs, size_t n)
+				{
+					const F& f = *static_cast<const F*>(ctx);
+					T* l = static_cast<T*>(lhs);
+					const T* r = static_cast<const T*>(rhs);
+					for (size_t i = 0; i < n; ++i)
+						f(l[i], r[i]);
+				};
+				reduce(items, sizeof(T), count, fn, &combine);
+			}
+
+			template<class Monoid, class Partial> void allreduce(Partial& partial)
+			{
+				allreduce(&partial, 1, [](Partial& lhs, const Partial& rhs) { Monoid::combine(lhs, rhs); });
+			}
+
+			// ReduceGroup: one opaque Fold partial per call
+			void allreduce(void* partial, size_t bytes, Combine combine) override
+			{
+				auto fn = [](const void* ctx, void* lhs, const void* rhs, size_t n)
+				{
+					if (n)
+						(*static_cast<const Combine*>(ctx))(lhs, rhs);
+				};
+				reduce(partial, bytes, 1, fn, &combine);
+			}
+
+		private:
+			using CombineN = void(*)(const void* ctx, void* lhs, const void* rhs, size_t n);
+
+			static bool power_of_two(int x) { return (x & (x - 1)) == 0; }
+
+			detail::Ring& ring(int src, int dst) { return mRings[src * mRanks + dst]; }
+
+			char* slot(int src, int dst, uint64_t i)
+			{
+				return mBase + mData + ((size_t(src) * mRanks + dst) * mSlots + i % mSlots) * mSlotBytes;
+			}
+
+			// Sends sbytes to dst while receiving rbytes from src (-1 skips a side), one slot at a time in both directions.
+			void exchange(int dst, const void* sbuf, size_t sbytes, int src, void* rbuf, size_t rbytes)
+			{
+				const char* s = static_cast<const char*>(sbuf);
+				char* r = static_cast<char*>(rbuf);
+				size_t sent = dst < 0 ? sbytes : 0;
+				size_t received = src < 0 ? rbytes : 0;
+
+				for (int spin = 0; sent < sbytes || received < rbytes; )
+				{
+					bool progress = false;
+
+					if (sent < sbytes)
+					{
+						detail::Ring& q = ring(mRank, dst);
+						const uint64_t head = q.head.load(std::memory_order_relaxed);
+						if (head - q.tail.load(std::memory_order_acquire) < uint64_t(mSlots))
+						{
+							const size_t n = std::min(mSlotBytes, sbytes - sent);
+							std::memcpy(slot(mRank, dst, head), s + sent, n);
+							q.head.store(head + 1, std::memory_order_release);
+							sent += n;
+							progress = true;
+						}
+					}
+
+					if (received < rbytes)
+					{
+						detail::Ring& q = ring(src, mRank);
+						const uint64_t tail = q.tail.load(std::memory_order_relaxed);
+						if (q.head.load(std::memory_order_acquire) != tail)
+						{
+							const size_t n = std::min(mSlotBytes, rbytes - received);
+							std::memcpy(r + received, slot(src, mRank, tail), n);
+							q.tail.store(tail + 1, std::memory_order_release);
+							received += n;
+							progress = true;
+						}
+					}
+
+					if (progress)
+						spin = 0;
+					else if (++spin < 1024)
+						_mm_pause();
+					else
+						std::this_thread::yield();
+				}
+			}
+
+			// combine() sees the scratch as Partial*, and partials are alignas(64)
+			char* scratch(size_t bytes)
+			{
+				if (mScratch.size() < bytes + 63)
+					mScratch.resize(bytes + 63);
+				return reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(mScratch.data()) + 63) & ~uintptr_t(63));
+			}
+
+			void reduce(void* items, size_t unit, size_t count, CombineN combine, const void* ctx)
+			{
+				if (mRanks == 1 || count == 0)
+					return;
+
+				char* data = static_cast<char*>(items);
+				const size_t bytes = unit * count;
+
+				if (power_of_two(mRanks))
+				{
+					if (bytes <= small_bytes || count < size_t(mRanks))
+						recursive_doubling(data, bytes, count, combine, ctx);
+					else
+						recursive_halving(data, unit, count, combine, ctx);
+				}
+				else
+				{
+					ring_reduce(data, unit, count, combine, ctx);
+				}
+			}
+
+			// log2(P) full exchanges; both partners compute combine(lower rank, higher rank)
+			void recursive_doubling(char* data, size_t bytes, size_t count, CombineN combine, const void* ctx)
+			{
+				char* tmp = scratch(bytes);
+				for (int mask = 1; mask < mRanks; mask <<= 1)
+				{
+					const int peer = mRank ^ mask;
+					exchange(peer, data, bytes, peer, tmp, bytes);
+					if (mRank < peer)
+					{
+						combine(ctx, data, tmp, count);
+					}
+					else
+					{
+						combine(ctx, tmp, data, count);
+						std::memcpy(data, tmp, bytes);
+					}
+				}
+			}
+
+			// Rabenseifner: reduce-scatter by recursive halving, then allgather by recursive doubling
+			void recursive_halving(char* data, size_t unit, size_t count, CombineN combine, const void* ctx)
+			{
+				char* tmp = scratch(unit * (count - count / 2));
+				size_t lo = 0, hi = count;
+				size_t held[2][32];
+				int level = 0;
+
+				for (int mask = mRanks >> 1; mask > 0; mask >>= 1, ++level)
+				{
+					const int peer = mRank ^ mask;
+					const size_t mid = lo + (hi - lo) / 2;
+					const bool lower = mRank < peer;
+					const size_t klo = lower ? lo : mid, khi = lower ? mid : hi;
+					const size_t slo = lower ? mid : lo, shi = lower ? hi : mid;
+
+					exchange(peer, data + slo * unit, (shi - slo) * unit, peer, tmp, (khi - klo) * unit);
+					if (lower)
+					{
+						combine(ctx, data + klo * unit, tmp, khi - klo);
+					}
+					else
+					{
+						combine(ctx, tmp, data + klo * unit, khi - klo);
+						std::memcpy(data + klo * unit, tmp, (khi - klo) * unit);
+					}
+					held[0][level] = lo;
+					held[1][level] = hi;
+					lo = klo;
+					hi = khi;
+				}
+
+				// walk back up: the peer holds the other half of the range both had before that halving step
+				for (int mask = 1; mask < mRanks; mask <<= 1)
+				{
+					--level;
+					const int peer = mRank ^ mask;
+					const size_t plo = lo == held[0][level] ? hi : held[0][level];
+					const size_t phi = lo == held[0][level] ? held[1][level] : lo;
+
+					exchange(peer, data + lo * unit, (hi - lo) * unit, peer, data + plo * unit, (phi - plo) * unit);
+					lo = held[0][level];
+					hi = held[1][level];
+				}
+			}
+
+			// reduce-scatter then allgather around the ring, P-1 steps each over P segments
+			void ring_reduce(char* data, size_t unit, size_t count, CombineN combine, const void* ctx)
+			{
+				const int next = (mRank + 1) % mRanks;
+				const int prev = (mRank + mRanks - 1) % mRanks;
+				auto seg_lo = [&](int k) { return count * k / mRanks; };
+				auto seg_len = [&](int k) { return seg_lo(k + 1) - seg_lo(k); };
+
+				char* tmp = scratch(unit * ((count + mRanks - 1) / mRanks));
+
+				for (int s = 0; s < mRanks - 1; ++s)
+				{
+					const int send = (mRank - s + mRanks) % mRanks;
+					const int recv = (mRank - s - 1 + 2 * mRanks) % mRanks;
+					exchange(next, data + seg_lo(send) * unit, seg_len(send) * unit, prev, tmp, seg_len(recv) * unit);
+					// tmp carries the ranks before this one on the ring
+					combine(ctx, tmp, data + seg_lo(recv) * unit, seg_len(recv));
+					std::memcpy(data + seg_lo(recv) * unit, tmp, seg_len(recv) * unit);
+				}
+
+				for (int s = 0; s < mRanks - 1; ++s)
+				{
+					const int send = (mRank + 1 - s + mRanks) % mRanks;
+					const int recv = (mRank - s + mRanks) % mRanks;
+					exchange(next, data + seg_lo(send) * unit, seg_len(send) * unit, prev, data + seg_lo(recv) * unit, seg_len(recv) * unit);
+				}
+			}
+
+			std::string mName;
+			int mRank;
+			int mRanks;
+			int mSlots = 0;
+			size_t mSlotBytes = 0;
+			int mSense = 0;
+
+			char* mBase = nullptr;
+			size_t mBytes = 0;
+			size_t mData = 0;
+			detail::Header* mHeader = nullptr;
+			detail::Ring* mRings = nullptr;
+			std::vector<char> mScratch;
+		};
+	}
+}
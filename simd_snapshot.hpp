@@ -0,0 +1,536 @@
+#pragma once
+#include "simd_array_avx512.hpp"
+#include "simd_mmap.hpp"
+
+#include <immintrin.h>
+#include <sys/uio.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <limits.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+
+namespace simd
+{
+	// Binary snapshots of Shared state and accumulators, for warm starts.
+	//
+	// File layout, all offsets 64-byte aligned:
+	//   Header            64 bytes
+	//   Entry[sections]   64 bytes each
+	//   section data      each padded with zeros to a multiple of 64 bytes
+	// Everything is stored in the byte order of the writer; a reader of the other byte order refuses the file.
+	// Header, table and every section carry a checksum.
+	namespace snapshot
+	{
+		namespace detail
+		{
+			static const uint64_t magic   = 0x73696d64736e7031ull; // "simdsnp1"
+			static const uint64_t swapped = 0x31706e73646d6973ull; // the same, read on the other byte order
+			static const uint32_t version = 1;
+			static const uint32_t endian  = 0x01020304u;
+			static const size_t   align   = 64;
+
+			// instruction sets the writer was built with, recorded in the header
+			namespace isa_bits
+			{
+				static const uint32_t sse42    = 1;
+				static const uint32_t avx2     = 2;
+				static const uint32_t fma      = 4;
+				static const uint32_t avx512f  = 8;
+				static const uint32_t avx512bw = 16;
+				static const uint32_t avx512dq = 32;
+				static const uint32_t avx512vl = 64;
+			}
+
+			inline uint32_t isa()
+			{
+				uint32_t bits = 0;
+#if defined(__SSE4_2__) || defined(__AVX__)
+				bits |= isa_bits::sse42;
+#endif
+#ifdef __AVX2__
+				bits |= isa_bits::avx2;
+#endif
+#if defined(__FMA__) || defined(__AVX2__)
+				bits |= isa_bits::fma;
+#endif
+#ifdef __AVX512F__
+				bits |= isa_bits::avx512f;
+#endif
+#ifdef __AVX512BW__
+				bits |= isa_bits::avx512bw;
+#endif
+#ifdef __AVX512DQ__
+				bits |= isa_bits::avx512dq;
+#endif
+#ifdef __AVX512VL__
+				bits |= isa_bits::avx512vl;
+#endif
+				return bits;
+			}
+
+			struct Header
+			{
+				uint64_t magic;
+				uint32_t version;
+				uint32_t endian;
+				uint32_t isa;
+				uint32_t alignment;
+				uint32_t sections;
+				uint32_t table_crc;
+				uint64_t user_tag;
+				uint64_t file_bytes;
+				uint64_t reserved;
+				uint32_t reserved2;
+				uint32_t header_crc;	// over the 60 bytes before it
+			};
+
+			struct Entry
+			{
+				char     name[24];
+				uint64_t offset;
+				uint64_t bytes;
+				uint64_t count;
+				uint32_t elem_size;
+				uint32_t type;
+				uint32_t crc;
+				uint32_t reserved;
+			};
+
+			static_assert(sizeof(Header) == 64 && sizeof(Entry) == 64, "snapshot header and entries are one cache line each");
+
+			// element type of a section, checked on load; 0 is any other trivially copyable type, checked by size only
+			template<class T> struct type_code : std::integral_constant<uint32_t, 0> {};
+			template<> struct type_code<float>                : std::integral_constant<uint32_t, 1> {};
+			template<> struct type_code<double>               : std::integral_constant<uint32_t, 2> {};
+			template<> struct type_code<int32_t>              : std::integral_constant<uint32_t, 3> {};
+			template<> struct type_code<int64_t>              : std::integral_constant<uint32_t, 4> {};
+			template<> struct type_code<uint32_t>             : std::integral_constant<uint32_t, 5> {};
+			template<> struct type_code<uint64_t>             : std::integral_constant<uint32_t, 6> {};
+			template<> struct type_code<int8_t>               : std::integral_constant<uint32_t, 7> {};
+			template<> struct type_code<uint8_t>              : std::integral_constant<uint32_t, 8> {};
+			template<> struct type_code<int16_t>              : std::integral_constant<uint32_t, 9> {};
+			template<> struct type_code<uint16_t>             : std::integral_constant<uint32_t, 10> {};
+			template<> struct type_code<std::complex<float>>  : std::integral_constant<uint32_t, 11> {};
+			template<> struct type_code<std::complex<double>> : std::integral_constant<uint32_t, 12> {};
+
+			// arrays whose begin() is a pointer to their contiguous elements (AlignedArray, AlignedVectorAVX512, ArrayView, ...)
+			template<class A, class = void> struct contiguous : std::false_type {};
+			template<class A> struct contiguous<A, std::enable_if_t<std::is_pointer<decltype(std::declval<A&>().begin())>::value>> : std::true_type {};
+
+			template<class A> using element_t = std::remove_const_t<std::remove_pointer_t<decltype(std::declval<A&>().begin())>>;
+
+			inline size_t padded(size_t bytes) { return (bytes + align - 1) & ~(align - 1); }
+
+			// CRC32C over four interleaved streams of 8-byte words, folded into one at the end: the crc32 instruction
+			// has a latency of three cycles and a throughput of one, so a single stream would run at a third of the speed
+			inline uint32_t checksum(const void* mem, size_t bytes)
+			{
+				const unsigned char* p = static_cast<const unsigned char*>(mem);
+				uint64_t c0 = 0xffffffffu, c1 = 0xffffffffu, c2 = 0xffffffffu, c3 = 0xffffffffu;
+				size_t i = 0;
+				for (; i + 32 <= bytes; i += 32)
+				{
+					uint64_t w[4];
+					std::memcpy(w, p + i, 32);
+					c0 = _mm_crc32_u64(c0, w[0]);
+					c1 = _mm_crc32_u64(c1, w[1]);
+					c2 = _mm_crc32_u64(c2, w[2]);
+					c3 = _mm_crc32_u64(c3, w[3]);
+				}
+				for (; i < bytes; ++i)
+					c0 = _mm_crc32_u8(uint32_t(c0), p[i]);
+
+				uint64_t c = 0xffffffffu;
+				c = _mm_crc32_u64(c, c0);
+				c = _mm_crc32_u64(c, c1);
+				c = _mm_crc32_u64(c, c2);
+				c = _mm_crc32_u64(c, c3);
+				c = _mm_crc32_u64(c, bytes);
+				return ~uint32_t(c);
+			}
+
+			[[noreturn]] inline void fail(const std::string& what)
+			{
+				throw std::system_error(errno, std::generic_category(), what);
+			}
+
+			[[noreturn]] inline void corrupt(const std::string& path, const char* what)
+			{
+				throw std::runtime_error("snapshot " + path + ": " + what);
+			}
+
+			// writev until every byte is out, IOV_MAX vectors at a time; one call unless the kernel writes short
+			inline void write_all(int fd, iovec* iov, size_t n, const std::string& path)
+			{
+				while (n > 0)
+				{
+					ssize_t done = ::writev(fd, iov, int(std::min<size_t>(n, IOV_MAX)));
+					if (done < 0)
+					{
+						if (errno == EINTR)
+							continue;
+						fail(path);
+					}
+
+					size_t left = size_t(done);
+					while (n > 0 && left >= iov->iov_len)
+					{
+						left -= iov->iov_len;
+						++iov;
+						--n;
+					}
+					if (n > 0)
+					{
+						iov->iov_base = static_cast<char*>(iov->iov_base) + left;
+						iov->iov_len -= left;
+					}
+				}
+			}
+		}
+
+		// Collects sections by name and writes them in one go. Only pointers are kept until save(),
+		// which reads the data as it is at that moment.
+		//   snapshot::Writer w(layout_version);
+		//   w.add("weights", shared.weights);      // AlignedArray, AlignedArrayAVX512, AlignedVectorAVX512, views
+		//   w.add("step", shared.step);            // any trivially copyable object
+		//   w.add_accums("moments", shared.moments); // every field of a FoldMulti container, via traverse_accums
+		//   w.save("model.snap");
+		class Writer
+		{
+			struct Item
+			{
+				detail::Entry entry;
+				const void* data;
+			};
+
+			std::vector<Item> mItems;
+			uint64_t mTag;
+
+		public:
+			// user_tag is stored in the header as is, e.g. a version of the Shared layout
+			explicit Writer(uint64_t user_tag = 0) : mTag(user_tag) {}
+
+			template<class T> void add(const char* name, const T* data, size_t count)
+			{
+				static_assert(std::is_trivially_copyable<T>::value, "snapshot sections hold trivially copyable elements");
+
+				const size_t len = std::strlen(name);
+				if (len == 0 || len >= sizeof(detail::Entry::name))
+					throw std::invalid_argument("snapshot::Writer: section names are 1 to 23 characters");
+				for (const Item& item : mItems)
+				{
+					if (std::strncmp(item.entry.name, name, sizeof(detail::Entry::name)) == 0)
+						throw std::invalid_argument(std::string("snapshot::Writer: duplicate section ") + name);
+				}
+
+				Item item{};
+				std::memcpy(item.entry.name, name, len);
+				item.entry.bytes = count * sizeof(T);
+				item.entry.count = count;
+				item.entry.elem_size = uint32_t(sizeof(T));
+				item.entry.type = detail::type_code<T>::value;
+				item.data = data;
+				mItems.push_back(item);
+			}
+
+			template<class A> void add(const char* name, const A& a)
+			{
+				if constexpr (detail::contiguous<const A>::value)
+					add(name, a.begin(), size_t(a.end() - a.begin()));
+				else
+					add(name, &a, 1);
+			}
+
+			// one section per field, named name.0, name.1, ... in traverse_accums order
+			template<class Container> void add_accums(const char* name, Container& c)
+			{
+				int i = 0;
+				traverse_accums(&c, &c, [&](auto& field, const auto&)
+				{
+					this->add((std::string(name) + "." + std::to_string(i++)).c_str(), field);
+				});
+			}
+
+			int size() const { return int(mItems.size()); }
+
+			// writes to path.tmp and renames it over path once it is on disk, a crash never leaves half a snapshot
+			// under path; returns the file size
+			size_t save(const std::string& path)
+			{
+				const size_t n = mItems.size();
+
+				detail::Header header{};
+				header.magic = detail::magic;
+				header.version = detail::version;
+				header.endian = detail::endian;
+				header.isa = detail::isa();
+				header.alignment = uint32_t(detail::align);
+				header.sections = uint32_t(n);
+				header.user_tag = mTag;
+
+				std::vector<detail::Entry> table(n);
+				size_t offset = sizeof(detail::Header) + n*sizeof(detail::Entry);
+				for (size_t i = 0; i < n; ++i)
+				{
+					table[i] = mItems[i].entry;
+					table[i].offset = offset;
+					table[i].crc = detail::checksum(mItems[i].data, table[i].bytes);
+					offset += detail::padded(table[i].bytes);
+				}
+				header.file_bytes = offset;
+				header.table_crc = detail::checksum(table.data(), n*sizeof(detail::Entry));
+				header.header_crc = detail::checksum(&header, offsetof(detail::Header, header_crc));
+
+				alignas(64) static const char zeros[detail::align] = {};
+
+				std::vector<iovec> iov;
+				iov.reserve(2 + 2*n);
+				iov.push_back({ &header, sizeof(header) });
+				if (n > 0)
+					iov.push_back({ table.data(), n*sizeof(detail::Entry) });
+				for (size_t i = 0; i < n; ++i)
+				{
+					if (table[i].bytes > 0)
+						iov.push_back({ const_cast<void*>(mItems[i].data), table[i].bytes });
+					if (size_t pad = detail::padded(table[i].bytes) - table[i].bytes)
+						iov.push_back({ const_cast<char*>(zeros), pad });
+				}
+
+				const std::string tmp = path + ".tmp";
+				int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+				if (fd < 0)
+					detail::fail(tmp);
+
+				try
+				{
+					detail::write_all(fd, iov.data(), iov.size(), tmp);
+					if (::fsync(fd) != 0)
+						detail::fail(tmp);
+				}
+				catch (...)
+				{
+					::close(fd);
+					::unlink(tmp.c_str());
+					throw;
+				}
+
+				if (::close(fd) != 0 || ::rename(tmp.c_str(), path.c_str()) != 0)
+				{
+					int err = errno;
+					::unlink(tmp.c_str());
+					throw std::system_error(err, std::generic_category(), path);
+				}
+				return offset;
+			}
+		};
+
+		// Maps a snapshot and hands its sections out in place, nothing is read until it is touched
+		// (mmap_flags::populate faults it all in up front). Header, table and file size are always checked;
+		// section checksums only with verify, which reads the whole file once, or one at a time with verify(name).
+		// Pointers and vectors from data()/vector() point into the mapping and are valid while the Reader lives.
+		// Pages stay in the page cache as in map_file: a store copies the page it touches into the process,
+		// unless mmap_flags::write_back is given and it goes to the file.
+		class Reader
+		{
+			std::string mPath;
+			void* mBase = MAP_FAILED;
+			size_t mLength = 0;
+			const detail::Header* mHeader = nullptr;
+			const detail::Entry* mTable = nullptr;
+
+			const detail::Entry& entry(const char* name) const
+			{
+				int i = find(name);
+				if (i < 0)
+					throw std::out_of_range("snapshot " + mPath + ": no section " + name);
+				return mTable[i];
+			}
+
+			template<class T> const detail::Entry& typed(const char* name) const
+			{
+				const detail::Entry& e = entry(name);
+				if (e.elem_size != sizeof(T) || e.type != detail::type_code<T>::value)
+					throw std::invalid_argument("snapshot " + mPath + ": section " + name + " holds a different element type");
+				return e;
+			}
+
+			char* at(const detail::Entry& e) const { return static_cast<char*>(mBase) + e.offset; }
+
+			void check(bool verify)
+			{
+				if (mLength < sizeof(detail::Header))
+					detail::corrupt(mPath, "too short for a header");
+
+				mHeader = static_cast<const detail::Header*>(mBase);
+				const detail::Header& h = *mHeader;
+				if (h.magic == detail::swapped)
+					detail::corrupt(mPath, "written on a machine of the other byte order");
+				if (h.magic != detail::magic)
+					detail::corrupt(mPath, "not a snapshot");
+				if (h.header_crc != detail::checksum(&h, offsetof(detail::Header, header_crc)))
+					detail::corrupt(mPath, "header checksum mismatch");
+				if (h.endian != detail::endian)
+					detail::corrupt(mPath, "written on a machine of the other byte order");
+				if (h.version > detail::version)
+					detail::corrupt(mPath, "written by a newer format version");
+				if (h.alignment != detail::align)
+					detail::corrupt(mPath, "unsupported section alignment");
+				if (h.file_bytes != mLength)
+					detail::corrupt(mPath, "truncated or extended since it was written");
+
+				const size_t n = h.sections;
+				if (sizeof(detail::Header) + n*sizeof(detail::Entry) > mLength)
+					detail::corrupt(mPath, "section table runs past the end of the file");
+				mTable = reinterpret_cast<const detail::Entry*>(mHeader + 1);
+				if (h.table_crc != detail::checksum(mTable, n*sizeof(detail::Entry)))
+					detail::corrupt(mPath, "section table checksum mismatch");
+
+				for (size_t i = 0; i < n; ++i)
+				{
+					const detail::Entry& e = mTable[i];
+					if (e.offset % detail::align || e.offset > mLength || e.bytes > mLength - e.offset
+						|| e.elem_size == 0 || e.bytes % e.elem_size || e.count != e.bytes / e.elem_size)
+						detail::corrupt(mPath, "section out of bounds");
+					if (verify && e.crc != detail::checksum(at(e), e.bytes))
+						throw std::runtime_error("snapshot " + mPath + ": checksum mismatch in section " + std::string(e.name, strnlen(e.name, sizeof(e.name))));
+				}
+			}
+
+		public:
+			explicit Reader(const std::string& path, int flags = mmap_flags::defaults, bool verify = false) : mPath(path)
+			{
+				int fd = ::open(path.c_str(), (flags & mmap_flags::write_back) ? O_RDWR : O_RDONLY);
+				if (fd < 0)
+					detail::fail(path);
+
+				struct stat st;
+				if (::fstat(fd, &st) != 0)
+				{
+					int err = errno;
+					::close(fd);
+					throw std::system_error(err, std::generic_category(), path);
+				}
+				mLength = size_t(st.st_size);
+				if (mLength == 0)
+				{
+					::close(fd);
+					detail::corrupt(path, "empty file");
+				}
+
+				mBase = simd::detail::map_range(fd, 0, mLength, flags).base;
+				int err = errno;
+				::close(fd);
+				if (mBase == MAP_FAILED)
+					throw std::system_error(err, std::generic_category(), path);
+
+				try
+				{
+					check(verify);
+				}
+				catch (...)
+				{
+					::munmap(mBase, mLength);
+					throw;
+				}
+			}
+
+			Reader(const Reader&) = delete;
+			Reader& operator=(const Reader&) = delete;
+
+			~Reader()
+			{
+				::munmap(mBase, mLength);
+			}
+
+			int size() const { return int(mHeader->sections); }
+			uint64_t user_tag() const { return mHeader->user_tag; }
+
+			// instruction sets of the writer (detail::isa_bits); the layout does not depend on them, a mismatch
+			// only means results were computed by a different build and may differ in the last bits
+			uint32_t isa() const { return mHeader->isa; }
+			bool same_isa() const { return mHeader->isa == detail::isa(); }
+
+			int find(const char* name) const
+			{
+				for (int i = 0; i < size(); ++i)
+				{
+					if (std::strncmp(mTable[i].name, name, sizeof(mTable[i].name)) == 0)
+						return i;
+				}
+				return -1;
+			}
+
+			bool contains(const char* name) const { return find(name) >= 0; }
+			size_t count(const char* name) const { return size_t(entry(name).count); }
+
+			// checks one section's checksum, for readers opened without verify
+			bool verify(const char* name) const
+			{
+				const detail::Entry& e = entry(name);
+				return e.crc == detail::checksum(at(e), e.bytes);
+			}
+
+			// the section's elements in place, 64-byte aligned
+			template<class T> T* data(const char* name) const
+			{
+				static_assert(std::is_trivially_copyable<T>::value, "snapshot sections hold trivially copyable elements");
+				return reinterpret_cast<T*>(at(typed<T>(name)));
+			}
+
+			// zero-copy AlignedVectorAVX512 over the section, e.g. shared.weights = reader.vector<float>("weights")
+			template<class T> AlignedVectorAVX512<T> vector(const char* name) const
+			{
+				const detail::Entry& e = typed<T>(name);
+				if (e.count > size_t(INT32_MAX))
+					throw std::length_error("snapshot " + mPath + ": section " + name + " is too long for a vector");
+				return AlignedVectorAVX512<T>(reinterpret_cast<T*>(at(e)), int(e.count));
+			}
+
+			// copies the section into an array of the same length or into a trivially copyable object,
+			// for fixed-size members (AlignedArray, AlignedArrayAVX512) that cannot point into the mapping
+			template<class A> void load(const char* name, A& a) const
+			{
+				if constexpr (detail::contiguous<A>::value)
+				{
+					using T = detail::element_t<A>;
+					const detail::Entry& e = typed<T>(name);
+					if (e.count != size_t(a.end() - a.begin()))
+						throw std::invalid_argument("snapshot " + mPath + ": section " + name + " has a different length");
+					std::memcpy(a.begin(), at(e), e.bytes);
+				}
+				else
+				{
+					static_assert(std::is_trivially_copyable<A>::value, "snapshot sections hold trivially copyable elements");
+					const detail::Entry& e = typed<A>(name);
+					if (e.count != 1)
+						throw std::invalid_argument("snapshot " + mPath + ": section " + name + " is not a single object");
+					std::memcpy(&a, at(e), sizeof(A));
+				}
+			}
+
+			// counterpart of Writer::add_accums
+			template<class Container> void load_accums(const char* name, Container& c) const
+			{
+				int i = 0;
+				traverse_accums(&c, &c, [&](auto& field, const auto&)
+				{
+					this->load((std::string(name) + "." + std::to_string(i++)).c_str(), field);
+				});
+			}
+		};
+	}
+}
@@ -0,0 +1,238 @@
+#pragma once
+#include "simd_array_avx512.hpp"
+
+#include <immintrin.h>
+#include <array>
+#include <cstdint>
+#include <utility>
+#include <type_traits>
+
+namespace simd
+{
+	namespace detail
+	{
+		template<class Field, class... Fields> struct field_index;
+		template<class Field, class... Fields> struct field_index<Field, Field, Fields...> : std::integral_constant<size_t, 0> {};
+		template<class Field, class Other, class... Fields> struct field_index<Field, Other, Fields...>
+			: std::integral_constant<size_t, 1 + field_index<Field, Fields...>::value> {};
+
+		template<class Scalar> struct SoAOps {};
+
+		template<> struct SoAOps<float>
+		{
+			using V = __m512;
+			using Index = int32_t;
+			static const int L = 16;
+			static V    load(const float* p)                      { return _mm512_loadu_ps(p); }
+			static void store(float* p, V v)                      { _mm512_storeu_ps(p, v); }
+			static V    zero()                                    { return _mm512_setzero_ps(); }
+			static V    permute(V src, unsigned m, const Index* idx, V a) { return _mm512_mask_permutexvar_ps(src, __mmask16(m), _mm512_loadu_si512(idx), a); }
+		};
+
+		template<> struct SoAOps<int>
+		{
+			using V = __m512i;
+			using Index = int32_t;
+			static const int L = 16;
+			static V    load(const int* p)                        { return _mm512_loadu_si512(p); }
+			static void store(int* p, V v)                        { _mm512_storeu_si512(p, v); }
+			static V    zero()                                    { return _mm512_setzero_si512(); }
+			static V    permute(V src, unsigned m, const Index* idx, V a) { return _mm512_mask_permutexvar_epi32(src, __mmask16(m), _mm512_loadu_si512(idx), a); }
+		};
+
+		template<> struct SoAOps<double>
+		{
+			using V = __m512d;
+			using Index = int64_t;
+			static const int L = 8;
+			static V    load(const double* p)                     { return _mm512_loadu_pd(p); }
+			static void store(double* p, V v)                     { _mm512_storeu_pd(p, v); }
+			static V    zero()                                    { return _mm512_setzero_pd(); }
+			static V    permute(V src, unsigned m, const Index* idx, V a) { return _mm512_mask_permutexvar_pd(src, __mmask8(m), _mm512_loadu_si512(idx), a); }
+		};
+
+		// Lane routing for one block of L elements with N fields: N AoS registers <-> N field registers.
+		// Output register o takes, from input register i, the lanes in mask[o][i] at positions index[o][i].
+		template<class Index, int N, int L> struct TransposeTable
+		{
+			Index index[N][N][L] = {};
+			unsigned mask[N][N] = {};
+
+			// AoS -> SoA: lane j of field f is AoS position j*N + f
+			static constexpr TransposeTable gather()
+			{
+				TransposeTable t{};
+				for (int f = 0; f < N; ++f)
+				{
+					for (int j = 0; j < L; ++j)
+					{
+						const int pos = j*N + f;
+						t.index[f][pos / L][j] = Index(pos % L);
+						t.mask[f][pos / L] |= 1u << j;
+					}
+				}
+				return t;
+			}
+
+			// SoA -> AoS: lane k of AoS register r is element (r*L + k) / N of field (r*L + k) % N
+			static constexpr TransposeTable scatter()
+			{
+				TransposeTable t{};
+				for (int r = 0; r < N; ++r)
+				{
+					for (int k = 0; k < L; ++k)
+					{
+						const int pos = r*L + k;
+						t.index[r][pos % N][k] = Index(pos / N);
+						t.mask[r][pos % N] |= 1u << k;
+					}
+				}
+				return t;
+			}
+		};
+
+		template<class Scalar, int N> struct Transpose
+		{
+			using Ops = SoAOps<Scalar>;
+			static const int L = Ops::L;
+			using Table = TransposeTable<typename Ops::Index, N, L>;
+
+			static void route(const Table& t, const typename Ops::V* in, typename Ops::V* out)
+			{
+				for (int o = 0; o < N; ++o)
+				{
+					typename Ops::V r = Ops::zero();
+					for (int i = 0; i < N; ++i)
+					{
+						if (t.mask[o][i])
+							r = Ops::permute(r, t.mask[o][i], t.index[o][i], in[i]);
+					}
+					out[o] = r;
+				}
+			}
+
+			// aos[i*N + f] -> soa[f][i] for i < n
+			static void from_aos(const Scalar* aos, Scalar* const* soa, int n)
+			{
+				static constexpr Table table = Table::gather();
+				typename Ops::V in[N], out[N];
+				int i = 0;
+				for (; i + L <= n; i += L)
+				{
+					for (int r = 0; r < N; ++r)
+						in[r] = Ops::load(aos + i*N + r*L);
+					route(table, in, out);
+					for (int f = 0; f < N; ++f)
+						Ops::store(soa[f] + i, out[f]);
+				}
+				for (; i < n; ++i)
+					for (int f = 0; f < N; ++f)
+						soa[f][i] = aos[i*N + f];
+			}
+
+			// soa[f][i] -> aos[i*N + f] for i < n
+			static void to_aos(const Scalar* const* soa, Scalar* aos, int n)
+			{
+				static constexpr Table table = Table::scatter();
+				typename Ops::V in[N], out[N];
+				int i = 0;
+				for (; i + L <= n; i += L)
+				{
+					for (int f = 0; f < N; ++f)
+						in[f] = Ops::load(soa[f] + i);
+					route(table, in, out);
+					for (int r = 0; r < N; ++r)
+						Ops::store(aos + i*N + r*L, out[r]);
+				}
+				for (; i < n; ++i)
+					for (int f = 0; f < N; ++f)
+						aos[i*N + f] = soa[f][i];
+			}
+		};
+	}
+
+	// One scalar per field, e.g. the FoldMulti target of an SoAArray source.
+	template<class Scalar, class... Fields> struct FieldValues
+	{
+		std::array<Scalar, sizeof...(Fields)> values{};
+
+		template<class Field> Scalar& get() { return values[detail::field_index<Field, Fields...>::value]; }
+		template<class Field> const Scalar& get() const { return values[detail::field_index<Field, Fields...>::value]; }
+	};
+
+	// Structure of arrays: one AlignedArrayAVX512<Scalar, Z> per field tag, Z == 0 for runtime-sized
+	// AlignedVectorAVX512 fields. Fields are reached by tag, a.get<velocity>() += a.get<force>() * dt.
+	template<class Scalar, int Z, class... Fields> class SoAArray
+	{
+		static_assert(sizeof...(Fields) > 0, "SoAArray needs at least one field");
+	public:
+		static const int N = int(sizeof...(Fields));
+		using ScalarType = Scalar;
+		using FieldArray = std::conditional_t<Z == 0, AlignedVectorAVX512<Scalar>, AlignedArrayAVX512<Scalar, Z>>;
+		using Values = FieldValues<Scalar, Fields...>;
+
+	private:
+		std::array<FieldArray, sizeof...(Fields)> fields;
+
+		template<size_t... I>
+		SoAArray(int n, std::pmr::memory_resource* res, std::index_sequence<I...>)
+			: fields{ { ((void)I, FieldArray(n, res))... } }
+		{
+		}
+
+		template<size_t... I> std::array<Scalar*, sizeof...(Fields)> pointers(std::index_sequence<I...>) { return { { fields[I].begin()... } }; }
+		template<size_t... I> std::array<const Scalar*, sizeof...(Fields)> pointers(std::index_sequence<I...>) const { return { { fields[I].begin()... } }; }
+
+	public:
+		SoAArray() = default;
+
+		template<int ZZ = Z, std::enable_if_t<ZZ == 0, int> = 0>
+		explicit SoAArray(int n, std::pmr::memory_resource* res = std::pmr::get_default_resource())
+			: SoAArray(n, res, std::make_index_sequence<sizeof...(Fields)>{})
+		{
+		}
+
+		int size() const { return int(fields[0].end() - fields[0].begin()); }
+
+		template<class Field> FieldArray& get() { return fields[detail::field_index<Field, Fields...>::value]; }
+		template<class Field> const FieldArray& get() const { return fields[detail::field_index<Field, Fields...>::value]; }
+
+		template<size_t I> FieldArray& field() { return fields[I]; }
+		template<size_t I> const FieldArray& field() const { return fields[I]; }
+
+		// f(field) for every field, in declaration order
+		template<class F> void for_each(const F& f)
+		{
+			for (auto& a : fields)
+				f(a);
+		}
+
+		// f(field, rhs's matching field)
+		template<class F> void for_each(const SoAArray& rhs, const F& f)
+		{
+			for (int i = 0; i < N; ++i)
+				f(fields[i], rhs.fields[i]);
+		}
+
+		// aos holds size() records of N scalars in field order
+		void load_aos(const Scalar* aos)
+		{
+			auto p = pointers(std::make_index_sequence<sizeof...(Fields)>{});
+			detail::Transpose<Scalar, N>::from_aos(aos, p.data(), size());
+		}
+
+		void store_aos(Scalar* aos) const
+		{
+			auto p = pointers(std::make_index_sequence<sizeof...(Fields)>{});
+			detail::Transpose<Scalar, N>::to_aos(p.data(), aos, size());
+		}
+	};
+
+	// FoldMulti walks every field: combine field by field between SoAArray partials, finish field by field
+	// into a target with the same tags (FieldValues, or another SoAArray).
+	template<class Target, class Scalar, int Z, class... Fields, class F>
+	void traverse_accums(Target* lhs, SoAArray<Scalar, Z, Fields...>* rhs, const F& f)
+	{
+		(f(lhs->template get<Fields>(), rhs->template get<Fields>()), ...);
+	}
+}
@@ -0,0 +1,715 @@
+#pragma once
+#include "simd_array_avx512.hpp"
+
+#include <immintrin.h>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <algorithm>
+#include <vector>
+#include <memory_resource>
+#include <utility>
+#include <type_traits>
+
+namespace simd
+{
+	// Sorting 32-bit keys (float, int32) in place, optionally carrying a 32-bit payload per key.
+	// Blocks of up to 256 keys are sorted in registers by bitonic networks; larger ranges are quicksorted
+	// with a compress-based partition. NaN keys are not supported. Sorts are not stable.
+	namespace sorting
+	{
+		template<class T> struct KeyOps {};
+
+		template<> struct KeyOps<float>
+		{
+			using V = __m512;
+			static float max_key()                                  { return INFINITY; }
+			static V    set1(float x)                               { return _mm512_set1_ps(x); }
+			static V    load(__mmask16 m, const float* p)           { return _mm512_mask_loadu_ps(set1(max_key()), m, p); }
+			static void store(float* p, __mmask16 m, V v)           { _mm512_mask_storeu_ps(p, m, v); }
+			static V    min(V a, V b)                               { return _mm512_min_ps(a, b); }
+			static V    max(V a, V b)                               { return _mm512_max_ps(a, b); }
+			static __mmask16 lt(V a, V b)                           { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+			static __mmask16 le(V a, V b)                           { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+			static __mmask16 eq(V a, V b)                           { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+			static V    permute(__m512i idx, V v)                   { return _mm512_permutexvar_ps(idx, v); }
+			static V    blend(__mmask16 m, V a, V b)                { return _mm512_mask_mov_ps(a, m, b); }
+			static V    compress(__mmask16 m, V v)                  { return _mm512_maskz_compress_ps(m, v); }
+			static float lane(V v, int i)                           { alignas(64) float t[16]; _mm512_store_ps(t, v); return t[i]; }
+		};
+
+		template<> struct KeyOps<int32_t>
+		{
+			using V = __m512i;
+			static int32_t max_key()                                { return INT32_MAX; }
+			static V    set1(int32_t x)                             { return _mm512_set1_epi32(x); }
+			static V    load(__mmask16 m, const int32_t* p)         { return _mm512_mask_loadu_epi32(set1(max_key()), m, p); }
+			static void store(int32_t* p, __mmask16 m, V v)         { _mm512_mask_storeu_epi32(p, m, v); }
+			static V    min(V a, V b)                               { return _mm512_min_epi32(a, b); }
+			static V    max(V a, V b)                               { return _mm512_max_epi32(a, b); }
+			static __mmask16 lt(V a, V b)                           { return _mm512_cmplt_epi32_mask(a, b); }
+			static __mmask16 le(V a, V b)                           { return _mm512_cmple_epi32_mask(a, b); }
+			static __mmask16 eq(V a, V b)                           { return _mm512_cmpeq_epi32_mask(a, b); }
+			static V    permute(__m512i idx, V v)                   { return _mm512_permutexvar_epi32(idx, v); }
+			static V    blend(__mmask16 m, V a, V b)                { return _mm512_mask_mov_epi32(a, m, b); }
+			static V    compress(__mmask16 m, V v)                  { return _mm512_maskz_compress_epi32(m, v); }
+			static int32_t lane(V v, int i)                         { alignas(64) int32_t t[16]; _mm512_store_si512(t, v); return t[i]; }
+		};
+
+		inline __mmask16 tail(int n) { return n >= 16 ? __mmask16(0xFFFF) : n <= 0 ? __mmask16(0) : __mmask16((1u << n) - 1); }
+
+		inline __m512i lanes() { return _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15); }
+
+		// lanes that keep the smaller key in the (size, distance) stage of a bitonic network
+		constexpr __mmask16 min_lanes(int size, int d)
+		{
+			unsigned m = 0;
+			for (int i = 0; i < 16; ++i)
+				if (((i & d) == 0) == ((i & size) == 0 || size >= 16))
+					m |= 1u << i;
+			return __mmask16(m);
+		}
+
+		struct NoPayload {};
+
+		// Register of keys, with or without payload; every network and partition step goes through these.
+		template<class K, class P> struct Lanes
+		{
+			using Ops = KeyOps<K>;
+			using Key = K;
+			using Val = P;
+			static_assert(sizeof(P) == 4, "payloads must be 32-bit");
+
+			struct Reg
+			{
+				typename Ops::V k;
+				__m512i v;
+			};
+
+			static Reg load(const K* k, const P* v, __mmask16 m)
+			{
+				return { Ops::load(m, k), _mm512_maskz_loadu_epi32(m, v) };
+			}
+
+			static void store(K* k, P* v, __mmask16 m, const Reg& r)
+			{
+				Ops::store(k, m, r.k);
+				_mm512_mask_storeu_epi32(v, m, r.v);
+			}
+
+			static void exchange(Reg& r, __m512i perm, __mmask16 keep_min)
+			{
+				const auto kp = Ops::permute(perm, r.k);
+				const auto vp = _mm512_permutexvar_epi32(perm, r.v);
+				const __mmask16 take = (keep_min & Ops::lt(kp, r.k)) | (~keep_min & Ops::lt(r.k, kp));
+				r.k = Ops::blend(take, r.k, kp);
+				r.v = _mm512_mask_mov_epi32(r.v, take, vp);
+			}
+
+			static void cross(Reg& lo, Reg& hi)
+			{
+				const __mmask16 take = Ops::lt(hi.k, lo.k);
+				const auto k = lo.k;
+				const auto v = lo.v;
+				lo.k = Ops::blend(take, lo.k, hi.k);
+				lo.v = _mm512_mask_mov_epi32(lo.v, take, hi.v);
+				hi.k = Ops::blend(take, hi.k, k);
+				hi.v = _mm512_mask_mov_epi32(hi.v, take, v);
+			}
+
+			static Reg reverse(const Reg& r)
+			{
+				const __m512i rev = _mm512_sub_epi32(_mm512_set1_epi32(15), lanes());
+				return { Ops::permute(rev, r.k), _mm512_permutexvar_epi32(rev, r.v) };
+			}
+
+			static void store_compress(K* k, P* v, __mmask16 m, const Reg& r)
+			{
+				const __mmask16 t = tail(_mm_popcnt_u32(m));
+				Ops::store(k, t, Ops::compress(m, r.k));
+				_mm512_mask_storeu_epi32(v, t, _mm512_maskz_compress_epi32(m, r.v));
+			}
+
+			static void swap(K* k, P* v, int i, int j)
+			{
+				std::swap(k[i], k[j]);
+				std::swap(v[i], v[j]);
+			}
+		};
+
+		template<class K> struct Lanes<K, NoPayload>
+		{
+			using Ops = KeyOps<K>;
+			using Key = K;
+			using Val = NoPayload;
+
+			struct Reg
+			{
+				typename Ops::V k;
+			};
+
+			static Reg  load(const K* k, const NoPayload*, __mmask16 m)             { return { Ops::load(m, k) }; }
+			static void store(K* k, NoPayload*, __mmask16 m, const Reg& r)         { Ops::store(k, m, r.k); }
+
+			static void exchange(Reg& r, __m512i perm, __mmask16 keep_min)
+			{
+				const auto kp = Ops::permute(perm, r.k);
+				r.k = Ops::blend(keep_min, Ops::max(r.k, kp), Ops::min(r.k, kp));
+			}
+
+			static void cross(Reg& lo, Reg& hi)
+			{
+				const auto k = lo.k;
+				lo.k = Ops::min(k, hi.k);
+				hi.k = Ops::max(k, hi.k);
+			}
+
+			static Reg reverse(const Reg& r)
+			{
+				return { Ops::permute(_mm512_sub_epi32(_mm512_set1_epi32(15), lanes()), r.k) };
+			}
+
+			static void store_compress(K* k, NoPayload*, __mmask16 m, const Reg& r)
+			{
+				Ops::store(k, tail(_mm_popcnt_u32(m)), Ops::compress(m, r.k));
+			}
+
+			static void swap(K* k, NoPayload*, int i, int j) { std::swap(k[i], k[j]); }
+		};
+
+		template<class L, int SIZE, int D> void stage(typename L::Reg& r)
+		{
+			L::exchange(r, _mm512_xor_si512(lanes(), _mm512_set1_epi32(D)), min_lanes(SIZE, D));
+		}
+
+		// full bitonic sort of one register
+		template<class L> void sort16(typename L::Reg& r)
+		{
+			stage<L, 2, 1>(r);
+			stage<L, 4, 2>(r); stage<L, 4, 1>(r);
+			stage<L, 8, 4>(r); stage<L, 8, 2>(r); stage<L, 8, 1>(r);
+			stage<L, 16, 8>(r); stage<L, 16, 4>(r); stage<L, 16, 2>(r); stage<L, 16, 1>(r);
+		}
+
+		// bitonic register to ascending
+		template<class L> void merge16(typename L::Reg& r)
+		{
+			stage<L, 16, 8>(r); stage<L, 16, 4>(r); stage<L, 16, 2>(r); stage<L, 16, 1>(r);
+		}
+
+		// N sorted registers in a row, N a power of two: runs of w registers are merged pairwise,
+		// the second run reversed so the pair is bitonic, then halved down to single registers
+		template<class L, int N> void merge_regs(typename L::Reg* r)
+		{
+			for (int w = 1; w < N; w *= 2)
+			{
+				for (int b = 0; b < N; b += 2 * w)
+				{
+					for (int j = 0; j < w; ++j)
+						r[b + w + j] = L::reverse(r[b + w + j]);
+					std::reverse(r + b + w, r + b + 2 * w);
+
+					for (int d = w; d >= 1; d /= 2)
+						for (int i = b; i < b + 2 * w; ++i)
+							if (((i - b) & d) == 0)
+								L::cross(r[i], r[i + d]);
+
+					for (int i = b; i < b + 2 * w; ++i)
+						merge16<L>(r[i]);
+				}
+			}
+		}
+
+		template<class L, int N> void sort_block(typename L::Key* k, typename L::Val* v, int n)
+		{
+			typename L::Reg r[N];
+			for (int i = 0; i < N; ++i)
+			{
+				r[i] = L::load(k + 16 * i, v + 16 * i, tail(n - 16 * i));
+				sort16<L>(r[i]);
+			}
+			merge_regs<L, N>(r);
+			for (int i = 0; i < N; ++i)
+				L::store(k + 16 * i, v + 16 * i, tail(n - 16 * i), r[i]);
+		}
+
+		static const int block = 256;
+
+		template<class L, bool INCLUSIVE>
+		int partition(typename L::Key* k, typename L::Val* v, int left, int right, typename L::Key pivot);
+
+		// up to 256 keys
+		template<class L> void sort_small(typename L::Key* k, typename L::Val* v, int n)
+		{
+			if (n <= 1)
+				return;
+
+			int regs = 1;
+			while (16 * regs < n)
+				regs *= 2;
+
+			// padding keys equal the largest key, so real maxima could trade payloads with padding:
+			// move them to the end first, they are already in place there
+			if constexpr (!std::is_same<typename L::Val, NoPayload>::value)
+			{
+				if (n < 16 * regs)
+				{
+					const int m = partition<L, false>(k, v, 0, n, L::Ops::max_key());
+					if (m < n)
+						return sort_small<L>(k, v, m);
+				}
+			}
+
+			switch (regs)
+			{
+			case 1:  sort_block<L, 1>(k, v, n); break;
+			case 2:  sort_block<L, 2>(k, v, n); break;
+			case 4:  sort_block<L, 4>(k, v, n); break;
+			case 8:  sort_block<L, 8>(k, v, n); break;
+			default: sort_block<L, 16>(k, v, n); break;
+			}
+		}
+
+		// Moves keys < pivot (<= pivot when INCLUSIVE) to the front of [left, right) and returns where they end.
+		// The first and last registers are held back so reads always stay ahead of the compressed writes;
+		// each register read is compress-stored in two pieces, low keys at the front and the rest at the back.
+		template<class L, bool INCLUSIVE>
+		int partition(typename L::Key* k, typename L::Val* v, int left, int right, typename L::Key pivot)
+		{
+			using Ops = typename L::Ops;
+
+			auto goes_right = [&](typename L::Key x) { return INCLUSIVE ? pivot < x : !(x < pivot); };
+			for (int i = (right - left) % 16; i > 0; --i)
+			{
+				if (goes_right(k[left]))
+					L::swap(k, v, left, --right);
+				else
+					++left;
+			}
+			if (right - left < 32)
+			{
+				for (int i = left; i < right; ++i)
+					if (!goes_right(k[i]))
+						L::swap(k, v, left++, i);
+				return left;
+			}
+
+			const auto p = Ops::set1(pivot);
+			auto split = [&](const typename L::Reg& r, int& ls, int& rs)
+			{
+				const __mmask16 high = INCLUSIVE ? Ops::lt(p, r.k) : __mmask16(~Ops::lt(r.k, p));
+				const int count = _mm_popcnt_u32(high);
+				L::store_compress(k + ls, v + ls, __mmask16(~high), r);
+				L::store_compress(k + rs - count, v + rs - count, high, r);
+				ls += 16 - count;
+				rs -= count;
+			};
+
+			const auto first = L::load(k + left, v + left, 0xFFFF);
+			const auto last = L::load(k + right - 16, v + right - 16, 0xFFFF);
+			int l = left + 16, r = right - 16;
+			int ls = left, rs = right;
+
+			while (l != r)
+			{
+				typename L::Reg cur;
+				if (rs - r < l - ls)
+				{
+					r -= 16;
+					cur = L::load(k + r, v + r, 0xFFFF);
+				}
+				else
+				{
+					cur = L::load(k + l, v + l, 0xFFFF);
+					l += 16;
+				}
+				split(cur, ls, rs);
+			}
+			split(first, ls, rs);
+			split(last, ls, rs);
+			return ls;
+		}
+
+		// median of 16 keys spread over [left, right)
+		template<class L> typename L::Key pivot(const typename L::Key* k, int left, int right)
+		{
+			using K = typename L::Key;
+			alignas(64) K s[16];
+			const int64_t step = (int64_t(right) - left) / 16;
+			for (int i = 0; i < 16; ++i)
+				s[i] = k[left + step * i + step / 2];
+
+			typename Lanes<K, NoPayload>::Reg r{ KeyOps<K>::load(0xFFFF, s) };
+			sort16<Lanes<K, NoPayload>>(r);
+			return KeyOps<K>::lane(r.k, 8);
+		}
+
+		template<class L> void sort_fallback(typename L::Key* k, typename L::Val* v, int n)
+		{
+			if constexpr (std::is_same<typename L::Val, NoPayload>::value)
+			{
+				std::sort(k, k + n);
+			}
+			else
+			{
+				std::vector<std::pair<typename L::Key, typename L::Val>> t(n);
+				for (int i = 0; i < n; ++i)
+					t[i] = { k[i], v[i] };
+				std::sort(t.begin(), t.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+				for (int i = 0; i < n; ++i)
+				{
+					k[i] = t[i].first;
+					v[i] = t[i].second;
+				}
+			}
+		}
+
+		// Splits [left, right) around a pivot; returns the bounds of the part still to be handled on each side.
+		// If the pivot is the smallest key, everything equal to it goes left and is already in place.
+		template<class L> void partition_step(typename L::Key* k, typename L::Val* v, int left, int right, int& left_end, int& right_begin)
+		{
+			const auto p = pivot<L>(k, left, right);
+			int split = partition<L, false>(k, v, left, right, p);
+			if (split == left)
+			{
+				left_end = left;
+				right_begin = partition<L, true>(k, v, left, right, p);
+			}
+			else
+			{
+				left_end = split;
+				right_begin = split;
+			}
+		}
+
+		template<class L> void quicksort(typename L::Key* k, typename L::Val* v, int left, int right, int depth)
+		{
+			while (right - left > block)
+			{
+				if (depth-- == 0)
+					return sort_fallback<L>(k + left, v ? v + left : v, right - left);
+
+				int le, rb;
+				partition_step<L>(k, v, left, right, le, rb);
+
+				// recurse into the smaller side, loop on the larger
+				if (le - left < right - rb)
+				{
+					quicksort<L>(k, v, left, le, depth);
+					left = rb;
+				}
+				else
+				{
+					quicksort<L>(k, v, rb, right, depth);
+					right = le;
+				}
+			}
+			sort_small<L>(k + left, v ? v + left : v, right - left);
+		}
+
+		template<class L> void select(typename L::Key* k, typename L::Val* v, int n, int nth)
+		{
+			int left = 0, right = n;
+			while (right - left > block)
+			{
+				int le, rb;
+				partition_step<L>(k, v, left, right, le, rb);
+				if (nth < le)
+					right = le;
+				else if (nth >= rb)
+					left = rb;
+				else
+					return;
+			}
+			sort_small<L>(k + left, v ? v + left : v, right - left);
+		}
+
+		inline int depth_limit(int n)
+		{
+			int d = 0;
+			while (n > 1)
+			{
+				n >>= 1;
+				d += 2;
+			}
+			return d;
+		}
+
+		// first index i of a (length na) such that merging a and b takes a[0, i) and b[0, out - i) as its first `out` elements
+		template<class K> int co_rank(int out, const K* a, int na, const K* b, int nb)
+		{
+			int lo = std::max(0, out - nb), hi = std::min(out, na);
+			while (lo < hi)
+			{
+				const int i = (lo + hi) / 2;
+				if (b[out - i - 1] < a[i])
+					hi = i;
+				else
+					lo = i + 1;
+			}
+			return lo;
+		}
+
+		template<class K, class P>
+		void merge_scalar(const K* ka, const P* va, int na, const K* kb, const P* vb, int nb, K* ko, P* vo)
+		{
+			int i = 0, j = 0, o = 0;
+			while (i < na && j < nb)
+			{
+				const bool take_b = kb[j] < ka[i];
+				ko[o] = take_b ? kb[j] : ka[i];
+				if constexpr (!std::is_same<P, NoPayload>::value)
+					vo[o] = take_b ? vb[j] : va[i];
+				j += take_b;
+				i += !take_b;
+				++o;
+			}
+			std::copy(ka + i, ka + na, ko + o);
+			std::copy(kb + j, kb + nb, ko + o + (na - i));
+			if constexpr (!std::is_same<P, NoPayload>::value)
+			{
+				std::copy(va + i, va + na, vo + o);
+				std::copy(vb + j, vb + nb, vo + o + (na - i));
+			}
+		}
+
+		// Streams 16 keys at a time from whichever run has the smaller head into a 32-key bitonic merge
+		// with the carried upper half; the lower half is final. The last few keys are merged scalar.
+		template<class L>
+		void merge(const typename L::Key* ka, const typename L::Val* va, int na, const typename L::Key* kb, const typename L::Val* vb, int nb,
+			typename L::Key* ko, typename L::Val* vo)
+		{
+			using K = typename L::Key;
+			using P = typename L::Val;
+			if (na < 16 || nb < 16)
+				return merge_scalar(ka, va, na, kb, vb, nb, ko, vo);
+
+			int i = 0, j = 0, o = 0;
+			bool short_a = false;
+			typename L::Reg carry;
+			if (ka[0] <= kb[0])
+			{
+				carry = L::load(ka, va, 0xFFFF);
+				i = 16;
+			}
+			else
+			{
+				carry = L::load(kb, vb, 0xFFFF);
+				j = 16;
+			}
+
+			for (;;)
+			{
+				typename L::Reg next;
+				const bool from_a = j == nb || (i < na && ka[i] <= kb[j]);
+				short_a = from_a;
+				if (from_a)
+				{
+					if (na - i < 16)
+						break;
+					next = L::load(ka + i, va + i, 0xFFFF);
+					i += 16;
+				}
+				else
+				{
+					if (nb - j < 16)
+						break;
+					next = L::load(kb + j, vb + j, 0xFFFF);
+					j += 16;
+				}
+
+				next = L::reverse(next);
+				L::cross(carry, next);
+				merge16<L>(carry);
+				merge16<L>(next);
+				L::store(ko + o, vo + o, 0xFFFF, carry);
+				carry = next;
+				o += 16;
+			}
+
+			// carry with the run that ran short (< 16 left), then that with the other run
+			K ck[16], tk[32];
+			P cv[16], tv[32];
+			L::store(ck, cv, 0xFFFF, carry);
+			const K* sk = short_a ? ka + i : kb + j;
+			const P* sv = short_a ? va + i : vb + j;
+			const int sn = short_a ? na - i : nb - j;
+			merge_scalar(ck, cv, 16, sk, sv, sn, tk, tv);
+			if (short_a)
+				merge_scalar(tk, tv, 16 + sn, kb + j, vb + j, nb - j, ko + o, vo + o);
+			else
+				merge_scalar(tk, tv, 16 + sn, ka + i, va + i, na - i, ko + o, vo + o);
+		}
+
+		// Each thread sorts 1/THREADS of the range, then sorted runs are merged pairwise; every round
+		// splits the output evenly between threads with merge-path co-ranks, ping-ponging through scratch.
+		template<class L, class Pool>
+		void parallel_sort(Pool& pool, typename L::Key* k, typename L::Val* v, int n)
+		{
+			using K = typename L::Key;
+			using P = typename L::Val;
+			const int T = Pool::threads;
+			constexpr bool payload = !std::is_same<P, NoPayload>::value;
+
+			if (T == 1 || n <= block * T)
+				return quicksort<L>(k, v, 0, n, depth_limit(n));
+
+			std::pmr::vector<K> tk(n, pool.Resource());
+			std::pmr::vector<std::conditional_t<payload, P, char>> tv(payload ? n : 0, pool.Resource());
+
+			std::vector<int> runs(T + 1);
+			for (int t = 0; t <= T; ++t)
+				runs[t] = int(int64_t(n) * t / T);
+
+			pool.Parallel([&](int t) { quicksort<L>(k + runs[t], payload ? v + runs[t] : v, 0, runs[t + 1] - runs[t], depth_limit(n)); });
+
+			K* src_k = k;
+			K* dst_k = tk.data();
+			P* src_v = v;
+			P* dst_v = payload ? reinterpret_cast<P*>(tv.data()) : v;
+
+			for (int width = 1; width < T; width *= 2)
+			{
+				pool.Parallel([&](int t)
+				{
+					const int out_begin = int(int64_t(n) * t / T);
+					const int out_end = int(int64_t(n) * (t + 1) / T);
+
+					for (int r = 0; r < T; r += 2 * width)
+					{
+						const int a0 = runs[r];
+						const int a1 = runs[std::min(r + width, T)];
+						const int b1 = runs[std::min(r + 2 * width, T)];
+						const int lo = std::max(out_begin, a0), hi = std::min(out_end, b1);
+						if (lo >= hi)
+							continue;
+
+						const int na = a1 - a0, nb = b1 - a1;
+						const int ia = co_rank(lo - a0, src_k + a0, na, src_k + a1, nb);
+						const int ie = co_rank(hi - a0, src_k + a0, na, src_k + a1, nb);
+						const int ja = (lo - a0) - ia, je = (hi - a0) - ie;
+
+						merge<L>(src_k + a0 + ia, payload ? src_v + a0 + ia : src_v, ie - ia,
+							src_k + a1 + ja, payload ? src_v + a1 + ja : src_v, je - ja,
+							dst_k + lo, payload ? dst_v + lo : dst_v);
+					}
+				});
+				std::swap(src_k, dst_k);
+				std::swap(src_v, dst_v);
+			}
+
+			if (src_k != k)
+			{
+				pool.Parallel([&](int t)
+				{
+					const int b = int(int64_t(n) * t / T), e = int(int64_t(n) * (t + 1) / T);
+					std::copy(src_k + b, src_k + e, k + b);
+					if constexpr (payload)
+						std::copy(src_v + b, src_v + e, v + b);
+				});
+			}
+		}
+
+		template<class Array> auto keys_of(Array& a) { return &*a.begin(); }
+		template<class Array> int count_of(Array& a) { return int(a.end() - a.begin()); }
+		template<class K> K* keys_of(K* p) { return p; }
+	}
+
+	// ascending, in place
+	template<class K> void sort(K* keys, int n)
+	{
+		using L = sorting::Lanes<K, sorting::NoPayload>;
+		sorting::quicksort<L>(keys, nullptr, 0, n, sorting::depth_limit(n));
+	}
+
+	// ascending by key, values[i] travels with keys[i]
+	template<class K, class P> void sort(K* keys, P* values, int n)
+	{
+		using L = sorting::Lanes<K, P>;
+		sorting::quicksort<L>(keys, values, 0, n, sorting::depth_limit(n));
+	}
+
+	// keys[nth] becomes the key a full sort would put there, with nothing larger before it and nothing smaller after
+	template<class K> void select(K* keys, int n, int nth)
+	{
+		sorting::select<sorting::Lanes<K, sorting::NoPayload>>(keys, nullptr, n, nth);
+	}
+
+	template<class K, class P> void select(K* keys, P* values, int n, int nth)
+	{
+		sorting::select<sorting::Lanes<K, P>>(keys, values, n, nth);
+	}
+
+	// the k smallest keys, ascending, in keys[0, k)
+	template<class K> void smallest_k(K* keys, int n, int k)
+	{
+		if (k <= 0)
+			return;
+		if (k < n)
+			select(keys, n, k - 1);
+		sort(keys, std::min(k, n));
+	}
+
+	template<class K, class P> void smallest_k(K* keys, P* values, int n, int k)
+	{
+		if (k <= 0)
+			return;
+		if (k < n)
+			select(keys, values, n, k - 1);
+		sort(keys, values, std::min(k, n));
+	}
+
+	// the k largest keys, descending, in keys[0, k)
+	template<class K> void largest_k(K* keys, int n, int k)
+	{
+		k = std::min(k, n);
+		if (k <= 0)
+			return;
+		if (k < n)
+			select(keys, n, n - k);
+		sort(keys + n - k, k);
+		std::reverse(keys + n - k, keys + n);
+		std::rotate(keys, keys + n - k, keys + n);
+	}
+
+	template<class K, class P> void largest_k(K* keys, P* values, int n, int k)
+	{
+		k = std::min(k, n);
+		if (k <= 0)
+			return;
+		if (k < n)
+			select(keys, values, n, n - k);
+		sort(keys + n - k, values + n - k, k);
+		std::reverse(keys + n - k, keys + n);
+		std::reverse(values + n - k, values + n);
+		std::rotate(keys, keys + n - k, keys + n);
+		std::rotate(values, values + n - k, values + n);
+	}
+
+	// sort over the Dispatcher's threads; scratch comes from the Dispatcher's memory resource
+	template<class Pool, class K> void parallel_sort(Pool& pool, K* keys, int n)
+	{
+		sorting::parallel_sort<sorting::Lanes<K, sorting::NoPayload>>(pool, keys, nullptr, n);
+	}
+
+	template<class Pool, class K, class P> void parallel_sort(Pool& pool, K* keys, P* values, int n)
+	{
+		sorting::parallel_sort<sorting::Lanes<K, P>>(pool, keys, values, n);
+	}
+
+	// whole-container forms for AlignedArrayAVX512 / AlignedVectorAVX512 / tiles
+	template<class Array, class = decltype(std::declval<Array&>().begin())> void sort(Array& a)
+	{
+		sort(sorting::keys_of(a), sorting::count_of(a));
+	}
+
+	template<class Array, class Values, class = decltype(std::declval<Array&>().begin())> void sort(Array& keys, Values& values)
+	{
+		sort(sorting::keys_of(keys), sorting::keys_of(values), sorting::count_of(keys));
+	}
+
+	template<class Pool, class Array, class = decltype(std::declval<Array&>().begin())> void parallel_sort(Pool& pool, Array& a)
+	{
+		parallel_sort(pool, sorting::keys_of(a), sorting::count_of(a));
+	}
+}
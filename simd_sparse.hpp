@@ -0,0 +1,539 @@
+#pragma once
+#include "simd.hpp"
+#include "simd_array_avx512.hpp"
+
+#include <immintrin.h>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+#include <memory_resource>
+#include <stdexcept>
+#include <utility>
+
+namespace simd
+{
+	namespace detail
+	{
+		template<class Scalar> struct SparseOps {};
+
+		template<> struct SparseOps<float>
+		{
+			static const int L = 16;
+			using M = __mmask16;
+			using V = __m512;
+			using I = __m512i;
+
+			static M    tail(int n)                                 { return n >= L ? M(0xFFFF) : M((1u << n) - 1); }
+			static I    load_index(M m, const int32_t* p)           { return _mm512_maskz_loadu_epi32(m, p); }
+			static V    load(M m, const float* p)                   { return _mm512_maskz_loadu_ps(m, p); }
+			static void store(float* p, M m, V v)                   { _mm512_mask_storeu_ps(p, m, v); }
+			static V    gather(M m, I i, const float* b)            { return _mm512_mask_i32gather_ps(_mm512_setzero_ps(), m, i, b, 4); }
+			static void scatter(float* b, M m, I i, V v)            { _mm512_mask_i32scatter_ps(b, m, i, v, 4); }
+			static V    set1(float x)                               { return _mm512_set1_ps(x); }
+			static V    zero()                                      { return _mm512_setzero_ps(); }
+			static V    add(V a, V b)                               { return _mm512_add_ps(a, b); }
+			static V    mul(V a, V b)                               { return _mm512_mul_ps(a, b); }
+			static V    fmadd(V a, V b, V c)                        { return _mm512_fmadd_ps(a, b, c); }
+			static float reduce(V v)                                { return _mm512_reduce_add_ps(v); }
+			static M    nonzero(M m, V v)                           { return _mm512_mask_cmp_ps_mask(m, v, _mm512_setzero_ps(), _CMP_NEQ_UQ); }
+			static I    iota(int base)                              { return _mm512_add_epi32(_mm512_set1_epi32(base), _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15)); }
+			static void compress_index(int32_t* p, M m, I i)        { _mm512_mask_storeu_epi32(p, tail(_mm_popcnt_u32(m)), _mm512_maskz_compress_epi32(m, i)); }
+			static void compress(float* p, M m, V v)                { _mm512_mask_storeu_ps(p, tail(_mm_popcnt_u32(m)), _mm512_maskz_compress_ps(m, v)); }
+			// lanes of todo with no earlier lane of todo holding the same index
+			static M    conflict_free(M todo, I i)                  { return _mm512_mask_testn_epi32_mask(todo, _mm512_conflict_epi32(i), _mm512_set1_epi32(todo)); }
+
+			// 16 values from src (lanes of m) to base[pos], or added onto it
+			static void scatter16(float* base, __mmask16 m, __m512i pos, const float* src)
+			{
+				_mm512_mask_i32scatter_ps(base, m, pos, _mm512_maskz_loadu_ps(m, src), 4);
+			}
+			static void scatter_add16(float* base, __mmask16 m, __m512i pos, const float* src)
+			{
+				_mm512_mask_i32scatter_ps(base, m, pos, _mm512_add_ps(gather(m, pos, base), _mm512_maskz_loadu_ps(m, src)), 4);
+			}
+		};
+
+		template<> struct SparseOps<double>
+		{
+			static const int L = 8;
+			using M = __mmask8;
+			using V = __m512d;
+			using I = __m256i;
+
+			static M    tail(int n)                                 { return n >= L ? M(0xFF) : M((1u << n) - 1); }
+			static I    load_index(M m, const int32_t* p)           { return _mm256_maskz_loadu_epi32(m, p); }
+			static V    load(M m, const double* p)                  { return _mm512_maskz_loadu_pd(m, p); }
+			static void store(double* p, M m, V v)                  { _mm512_mask_storeu_pd(p, m, v); }
+			static V    gather(M m, I i, const double* b)           { return _mm512_mask_i32gather_pd(_mm512_setzero_pd(), m, i, b, 8); }
+			static void scatter(double* b, M m, I i, V v)           { _mm512_mask_i32scatter_pd(b, m, i, v, 8); }
+			static V    set1(double x)                              { return _mm512_set1_pd(x); }
+			static V    zero()                                      { return _mm512_setzero_pd(); }
+			static V    add(V a, V b)                               { return _mm512_add_pd(a, b); }
+			static V    mul(V a, V b)                               { return _mm512_mul_pd(a, b); }
+			static V    fmadd(V a, V b, V c)                        { return _mm512_fmadd_pd(a, b, c); }
+			static double reduce(V v)                               { return _mm512_reduce_add_pd(v); }
+			static M    nonzero(M m, V v)                           { return _mm512_mask_cmp_pd_mask(m, v, _mm512_setzero_pd(), _CMP_NEQ_UQ); }
+			static I    iota(int base)                              { return _mm256_add_epi32(_mm256_set1_epi32(base), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7)); }
+			static void compress_index(int32_t* p, M m, I i)        { _mm256_mask_storeu_epi32(p, tail(_mm_popcnt_u32(m)), _mm256_maskz_compress_epi32(m, i)); }
+			static void compress(double* p, M m, V v)               { _mm512_mask_storeu_pd(p, tail(_mm_popcnt_u32(m)), _mm512_maskz_compress_pd(m, v)); }
+			static M    conflict_free(M todo, I i)                  { return _mm256_mask_testn_epi32_mask(todo, _mm256_conflict_epi32(i), _mm256_set1_epi32(todo)); }
+
+			// 16 values as two halves of 8
+			static void scatter16(double* base, __mmask16 m, __m512i pos, const double* src)
+			{
+				const M lo = M(m), hi = M(m >> 8);
+				_mm512_mask_i32scatter_pd(base, lo, _mm512_castsi512_si256(pos), _mm512_maskz_loadu_pd(lo, src), 8);
+				_mm512_mask_i32scatter_pd(base, hi, _mm512_extracti64x4_epi64(pos, 1), _mm512_maskz_loadu_pd(hi, src + 8), 8);
+			}
+			static void scatter_add16(double* base, __mmask16 m, __m512i pos, const double* src)
+			{
+				const M lo = M(m), hi = M(m >> 8);
+				const I plo = _mm512_castsi512_si256(pos), phi = _mm512_extracti64x4_epi64(pos, 1);
+				_mm512_mask_i32scatter_pd(base, lo, plo, _mm512_add_pd(gather(lo, plo, base), _mm512_maskz_loadu_pd(lo, src)), 8);
+				_mm512_mask_i32scatter_pd(base, hi, phi, _mm512_add_pd(gather(hi, phi, base), _mm512_maskz_loadu_pd(hi, src + 8)), 8);
+			}
+		};
+
+		inline __mmask16 index_tail(int n) { return n >= 16 ? __mmask16(0xFFFF) : __mmask16((1u << n) - 1); }
+
+		// lane i = number of set bits of m below i
+		inline __m512i exclusive_count(__mmask16 m)
+		{
+			const __m512i zero = _mm512_setzero_si512();
+			const __m512i x = _mm512_maskz_mov_epi32(m, _mm512_set1_epi32(1));
+			__m512i s = _mm512_add_epi32(x, _mm512_alignr_epi32(x, zero, 15));
+			s = _mm512_add_epi32(s, _mm512_alignr_epi32(s, zero, 14));
+			s = _mm512_add_epi32(s, _mm512_alignr_epi32(s, zero, 12));
+			s = _mm512_add_epi32(s, _mm512_alignr_epi32(s, zero, 8));
+			return _mm512_sub_epi32(s, x);
+		}
+
+		// per-thread scratch, grown on demand; slot 0 is handed back zeroed, slot 1 holds garbage
+		template<class T> std::vector<T>& sparse_scratch(size_t n, int slot)
+		{
+			thread_local std::vector<T> s[2];
+			if (s[slot].size() < n)
+				s[slot].resize(n);
+			return s[slot];
+		}
+	}
+
+	// y[index[k]] += a * value[k] for k < count. Indices may repeat and come in any order:
+	// lanes hitting the same element within one register are serialised with conflict detection.
+	template<class Scalar> void scatter_add(Scalar* y, const int32_t* index, const Scalar* value, int count, Scalar a = Scalar(1))
+	{
+		using Ops = detail::SparseOps<Scalar>;
+		const auto va = Ops::set1(a);
+
+		for (int k = 0; k < count; k += Ops::L)
+		{
+			auto m = Ops::tail(count - k);
+			auto i = Ops::load_index(m, index + k);
+			auto v = Ops::load(m, value + k);
+
+			while (m)
+			{
+				auto safe = Ops::conflict_free(m, i);
+				Ops::scatter(y, safe, i, Ops::fmadd(va, v, Ops::gather(safe, i, y)));
+				m &= ~safe;
+			}
+		}
+	}
+
+	// Sparse vector of logical length size(), stored as strictly increasing int32 indices with their values
+	// in 64-byte aligned blocks. Kernels work a register of indices at a time (16 floats / 8 doubles)
+	// with masked gathers and scatters against dense arrays of the same length.
+	// operator+= and fold() make it a valid monoid::sum partial, so it can be a Fold/FoldMulti accumulator.
+	template<class Scalar> class SparseVectorAVX512
+	{
+		using Ops = detail::SparseOps<Scalar>;
+		static const int L = Ops::L;
+
+		int32_t* index = nullptr;
+		Scalar*  value = nullptr;
+		int n = 0;
+		int nnz = 0;
+		int capacity = 0;
+		std::pmr::memory_resource* resource;
+
+		static int round_up(int x) { return (x + L - 1) / L * L; }
+
+		void release()
+		{
+			if (capacity)
+			{
+				resource->deallocate(index, capacity * sizeof(int32_t), 64);
+				resource->deallocate(value, capacity * sizeof(Scalar), 64);
+			}
+			index = nullptr;
+			value = nullptr;
+			capacity = 0;
+		}
+
+		template<class Dense> static Scalar* dense_data(Dense& d) { return &*d.begin(); }
+		template<class Dense> static const Scalar* dense_data(const Dense& d) { return &*d.begin(); }
+
+		static Scalar* dense_data(Scalar* d) { return d; }
+		static const Scalar* dense_data(const Scalar* d) { return d; }
+
+	public:
+		using ScalarType = Scalar;
+
+		explicit SparseVectorAVX512(int size = 0, std::pmr::memory_resource* res = std::pmr::get_default_resource())
+			: n(size), resource(res)
+		{}
+
+		SparseVectorAVX512(const SparseVectorAVX512& rhs)
+			: n(rhs.n), resource(rhs.resource)
+		{
+			*this = rhs;
+		}
+
+		SparseVectorAVX512(SparseVectorAVX512&& rhs) noexcept
+			: index(rhs.index), value(rhs.value), n(rhs.n), nnz(rhs.nnz), capacity(rhs.capacity), resource(rhs.resource)
+		{
+			rhs.index = nullptr;
+			rhs.value = nullptr;
+			rhs.nnz = 0;
+			rhs.capacity = 0;
+		}
+
+		SparseVectorAVX512& operator=(const SparseVectorAVX512& rhs)
+		{
+			if (this == &rhs)
+				return *this;
+
+			n = rhs.n;
+			nnz = 0;
+			reserve(rhs.nnz);
+			std::memcpy(index, rhs.index, rhs.nnz * sizeof(int32_t));
+			std::memcpy(value, rhs.value, rhs.nnz * sizeof(Scalar));
+			nnz = rhs.nnz;
+			return *this;
+		}
+
+		SparseVectorAVX512& operator=(SparseVectorAVX512&& rhs) noexcept
+		{
+			if (this != &rhs)
+			{
+				release();
+				std::swap(index, rhs.index);
+				std::swap(value, rhs.value);
+				std::swap(capacity, rhs.capacity);
+				std::swap(resource, rhs.resource);
+				n = rhs.n;
+				nnz = rhs.nnz;
+				rhs.nnz = 0;
+			}
+			return *this;
+		}
+
+		~SparseVectorAVX512()
+		{
+			release();
+		}
+
+		int size() const { return n; }
+		int nonzeros() const { return nnz; }
+
+		const int32_t* indices() const { return index; }
+		const Scalar*  values() const { return value; }
+		Scalar*        values() { return value; }
+
+		// keeps the storage
+		void clear() { nnz = 0; }
+
+		void resize(int size)
+		{
+			n = size;
+			nnz = 0;
+		}
+
+		void reserve(int count)
+		{
+			if (count <= capacity)
+				return;
+
+			const int c = round_up(count);
+			int32_t* i = static_cast<int32_t*>(resource->allocate(c * sizeof(int32_t), 64));
+			Scalar*  v = nullptr;
+			try
+			{
+				v = static_cast<Scalar*>(resource->allocate(c * sizeof(Scalar), 64));
+			}
+			catch (...)
+			{
+				resource->deallocate(i, c * sizeof(int32_t), 64);
+				throw;
+			}
+			if (nnz)
+			{
+				std::memcpy(i, index, nnz * sizeof(int32_t));
+				std::memcpy(v, value, nnz * sizeof(Scalar));
+			}
+			release();
+			index = i;
+			value = v;
+			capacity = c;
+		}
+
+		// indices must be strictly increasing
+		void push_back(int i, Scalar v)
+		{
+			if (i < 0 || i >= n || (nnz && i <= index[nnz - 1]))
+				throw std::invalid_argument("SparseVectorAVX512: indices must increase and stay below size()");
+			if (nnz == capacity)
+				reserve(capacity ? 2 * capacity : L);
+			index[nnz] = i;
+			value[nnz] = v;
+			++nnz;
+		}
+
+		// keeps the nonzeros of dense[0, size()), compressed a register at a time
+		template<class Dense> void assign_dense(const Dense& dense)
+		{
+			const Scalar* d = dense_data(dense);
+
+			int count = 0;
+			for (int k = 0; k < n; k += L)
+			{
+				auto m = Ops::tail(n - k);
+				count += _mm_popcnt_u32(Ops::nonzero(m, Ops::load(m, d + k)));
+			}
+
+			nnz = 0;
+			reserve(count);
+			for (int k = 0; k < n; k += L)
+			{
+				auto m = Ops::tail(n - k);
+				auto v = Ops::load(m, d + k);
+				auto nz = Ops::nonzero(m, v);
+				Ops::compress(value + nnz, nz, v);
+				Ops::compress_index(index + nnz, nz, Ops::iota(k));
+				nnz += _mm_popcnt_u32(nz);
+			}
+		}
+
+		// builds from unsorted (index, value) pairs, summing repeated indices
+		void assign_pairs(const int32_t* pairs_index, const Scalar* pairs_value, int count)
+		{
+			const int words = (n + 63) / 64;
+			auto& dense = detail::sparse_scratch<Scalar>(size_t(words) * 64, 0);
+			auto& bits  = detail::sparse_scratch<uint64_t>(words, 0);
+
+			// the scratch is handed back zeroed: nothing may be left in it when this throws
+			for (int k = 0; k < count; ++k)
+			{
+				const int32_t i = pairs_index[k];
+				if (i < 0 || i >= n)
+					throw std::out_of_range("SparseVectorAVX512: index outside size()");
+			}
+
+			for (int k = 0; k < count; ++k)
+				bits[pairs_index[k] >> 6] |= uint64_t(1) << (pairs_index[k] & 63);
+			scatter_add(dense.data(), pairs_index, pairs_value, count);
+
+			int total = 0;
+			for (int w = 0; w < words; ++w)
+				total += int(_mm_popcnt_u64(bits[w]));
+
+			nnz = 0;
+			try
+			{
+				reserve(total);
+			}
+			catch (...)
+			{
+				for (int k = 0; k < count; ++k)
+				{
+					dense[pairs_index[k]] = Scalar{};
+					bits[pairs_index[k] >> 6] = 0;
+				}
+				throw;
+			}
+			for (int w = 0; w < words; ++w)
+			{
+				const uint64_t u = bits[w];
+				if (!u)
+					continue;
+				bits[w] = 0;
+
+				for (int s = 0; s < 64; s += L)
+				{
+					const auto m = static_cast<typename Ops::M>(u >> s);
+					if (!m)
+						continue;
+					Scalar* d = dense.data() + w * 64 + s;
+					Ops::compress(value + nnz, m, Ops::load(m, d));
+					Ops::compress_index(index + nnz, m, Ops::iota(w * 64 + s));
+					Ops::store(d, m, Ops::zero());
+					nnz += _mm_popcnt_u32(m);
+				}
+			}
+		}
+
+		Scalar fold() const
+		{
+			auto acc = Ops::zero();
+			for (int k = 0; k < nnz; k += L)
+				acc = Ops::add(acc, Ops::load(Ops::tail(nnz - k), value + k));
+			return Ops::reduce(acc);
+		}
+
+		SparseVectorAVX512& operator*=(Scalar a)
+		{
+			const auto va = Ops::set1(a);
+			for (int k = 0; k < nnz; k += L)
+			{
+				auto m = Ops::tail(nnz - k);
+				Ops::store(value + k, m, Ops::mul(va, Ops::load(m, value + k)));
+			}
+			return *this;
+		}
+
+		// sum of x[i] * dense[i] over the nonzeros, two gathers in flight
+		template<class Dense> Scalar dot(const Dense& dense) const
+		{
+			const Scalar* d = dense_data(dense);
+			auto acc0 = Ops::zero(), acc1 = Ops::zero();
+			int k = 0;
+			for (; k + 2 * L <= nnz; k += 2 * L)
+			{
+				const auto full = Ops::tail(L);
+				acc0 = Ops::fmadd(Ops::load(full, value + k),     Ops::gather(full, Ops::load_index(full, index + k), d), acc0);
+				acc1 = Ops::fmadd(Ops::load(full, value + k + L), Ops::gather(full, Ops::load_index(full, index + k + L), d), acc1);
+			}
+			for (; k < nnz; k += L)
+			{
+				const auto m = Ops::tail(nnz - k);
+				acc0 = Ops::fmadd(Ops::load(m, value + k), Ops::gather(m, Ops::load_index(m, index + k), d), acc0);
+			}
+			return Ops::reduce(Ops::add(acc0, acc1));
+		}
+
+		// dense += a * x; indices are unique, so no conflict handling is needed
+		template<class Dense> void axpy(Scalar a, Dense&& dense) const
+		{
+			Scalar* d = dense_data(dense);
+			const auto va = Ops::set1(a);
+			for (int k = 0; k < nnz; k += L)
+			{
+				const auto m = Ops::tail(nnz - k);
+				const auto i = Ops::load_index(m, index + k);
+				Ops::scatter(d, m, i, Ops::fmadd(va, Ops::load(m, value + k), Ops::gather(m, i, d)));
+			}
+		}
+
+		template<class Dense> void to_dense(Dense&& dense) const
+		{
+			Scalar* d = dense_data(dense);
+			std::fill(d, d + n, Scalar(0));
+			axpy(Scalar(1), d);
+		}
+
+		// Merges the union of both index sets, 16 indices of each side per step without data-dependent branches:
+		// entries up to the smaller of the two blocks' last index are ranked against the other block (16 permutes
+		// and compares), equal indices are detected on the way, and both blocks are scattered to their final slots.
+		SparseVectorAVX512& operator+=(const SparseVectorAVX512& rhs)
+		{
+			if (rhs.n != n)
+				throw std::invalid_argument("SparseVectorAVX512: size mismatch");
+			if (!rhs.nnz)
+				return *this;
+
+			auto& out_index = detail::sparse_scratch<int32_t>(nnz + rhs.nnz, 1);
+			auto& out_value = detail::sparse_scratch<Scalar>(nnz + rhs.nnz, 1);
+			int32_t* oi = out_index.data();
+			Scalar*  ov = out_value.data();
+
+			const __m512i one  = _mm512_set1_epi32(1);
+			const __m512i last = _mm512_set1_epi32(15);
+			const __m512i pad  = _mm512_set1_epi32(INT32_MAX);
+			const __m512i lane = _mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+
+			int pa = 0, pb = 0, po = 0;
+			while (pa < nnz && pb < rhs.nnz)
+			{
+				const __mmask16 la = detail::index_tail(nnz - pa);
+				const __mmask16 lb = detail::index_tail(rhs.nnz - pb);
+				const __m512i a = _mm512_mask_loadu_epi32(pad, la, index + pa);
+				const __m512i b = _mm512_mask_loadu_epi32(pad, lb, rhs.index + pb);
+
+				const __m512i t = _mm512_min_epi32(_mm512_permutexvar_epi32(last, a), _mm512_permutexvar_epi32(last, b));
+				const __mmask16 va = _mm512_mask_cmple_epi32_mask(la, a, t);
+				const __mmask16 vb = _mm512_mask_cmple_epi32_mask(lb, b, t);
+
+				// lt_a[i] = #{b < a[i]}, eq_a: a[i] also in b; likewise for b
+				__m512i lt_a = _mm512_setzero_si512(), lt_b = _mm512_setzero_si512(), rot = lane;
+				__mmask16 eq_a = 0, eq_b = 0;
+				for (int k = 0; k < 16; ++k)
+				{
+					const __m512i br = _mm512_permutexvar_epi32(rot, b);
+					const __m512i ar = _mm512_permutexvar_epi32(rot, a);
+					lt_a = _mm512_mask_add_epi32(lt_a, _mm512_cmplt_epi32_mask(br, a), lt_a, one);
+					lt_b = _mm512_mask_add_epi32(lt_b, _mm512_cmplt_epi32_mask(ar, b), lt_b, one);
+					eq_a |= _mm512_cmpeq_epi32_mask(br, a);
+					eq_b |= _mm512_cmpeq_epi32_mask(ar, b);
+					rot = _mm512_and_si512(_mm512_add_epi32(rot, one), last);
+				}
+				eq_a &= va;
+				eq_b &= vb;
+
+				// slot = own rank + rank in the other block - shared indices below
+				const __m512i pos_a = _mm512_add_epi32(_mm512_set1_epi32(po), _mm512_sub_epi32(_mm512_add_epi32(lane, lt_a), detail::exclusive_count(eq_a)));
+				const __m512i pos_b = _mm512_add_epi32(_mm512_set1_epi32(po), _mm512_sub_epi32(_mm512_add_epi32(lane, lt_b), detail::exclusive_count(eq_b)));
+
+				_mm512_mask_i32scatter_epi32(oi, va, pos_a, a, 4);
+				Ops::scatter16(ov, va, pos_a, value + pa);
+				_mm512_mask_i32scatter_epi32(oi, vb & ~eq_b, pos_b, b, 4);
+				Ops::scatter16(ov, vb & ~eq_b, pos_b, rhs.value + pb);
+				Ops::scatter_add16(ov, eq_b, pos_b, rhs.value + pb);
+
+				const int ca = _mm_popcnt_u32(va), cb = _mm_popcnt_u32(vb);
+				pa += ca;
+				pb += cb;
+				po += ca + cb - _mm_popcnt_u32(eq_a);
+			}
+
+			std::memcpy(oi + po, index + pa, (nnz - pa) * sizeof(int32_t));
+			std::memcpy(ov + po, value + pa, (nnz - pa) * sizeof(Scalar));
+			po += nnz - pa;
+			std::memcpy(oi + po, rhs.index + pb, (rhs.nnz - pb) * sizeof(int32_t));
+			std::memcpy(ov + po, rhs.value + pb, (rhs.nnz - pb) * sizeof(Scalar));
+			po += rhs.nnz - pb;
+
+			reserve(po);
+			std::memcpy(index, oi, po * sizeof(int32_t));
+			std::memcpy(value, ov, po * sizeof(Scalar));
+			nnz = po;
+			return *this;
+		}
+	};
+
+	template<class Scalar, class Dense> Scalar dot(const SparseVectorAVX512<Scalar>& x, const Dense& y)
+	{
+		return x.dot(y);
+	}
+
+	template<class Scalar, class Dense> void axpy(Scalar a, const SparseVectorAVX512<Scalar>& x, Dense&& y)
+	{
+		x.axpy(a, y);
+	}
+
+	namespace monoid
+	{
+		// Fold/FoldMulti over sparse accumulators: partials are merged, finish() hands over the whole vector
+		// (or scatters it into a dense target) instead of summing it to a scalar like monoid::sum
+		struct sparse_sum
+		{
+			template<class DataBatch> using Partial = DataBatch;
+			template<class Scalar>    using Result  = Scalar;
+
+			template<class Sparse> static void combine(Sparse& lhs, const Sparse& rhs) { lhs += rhs; }
+
+			template<class Scalar> static void finish(const SparseVectorAVX512<Scalar>& src, SparseVectorAVX512<Scalar>& target) { target = src; }
+			template<class Scalar, class Dense> static void finish(const SparseVectorAVX512<Scalar>& src, Dense& target) { src.to_dense(target); }
+		};
+	}
+}
@@ -0,0 +1,91 @@
+#pragma once
+#include "simd_array_avx512.hpp"
+#include "simd_view.hpp"
+
+#include <immintrin.h>
+#include <cstddef>
+#include <algorithm>
+
+namespace simd
+{
+	namespace tiles
+	{
+		// combined footprint of one tile of every array, roughly half of L2
+		inline size_t budget = size_t(256) << 10;
+	}
+
+	namespace detail
+	{
+		template<class Array> int elements(Array& a)
+		{
+			return static_cast<int>(a.end() - a.begin());
+		}
+
+		inline void prefetch_range(const void* p, size_t bytes)
+		{
+			const char* c = static_cast<const char*>(p);
+			for (size_t i = 0; i < bytes; i += 64)
+				_mm_prefetch(c + i, _MM_HINT_T1);
+		}
+
+		// tiles are temporaries bound here, so the callback sees them as lvalues
+		template<class F, class... Tiles> void call_with_tiles(const F& f, Tiles&&... tiles)
+		{
+			f(tiles...);
+		}
+
+		// elements per tile so that one tile of each array fits the budget, in whole registers
+		template<class... Arrays> int tile_elements()
+		{
+			const size_t row = (sizeof(typename Arrays::ScalarType) + ...);
+			size_t n = (tiles::budget / row) & ~size_t(63);
+			return static_cast<int>(n ? n : 64);
+		}
+	}
+
+	// Runs f(tile_of_array0, tile_of_array1, ...) over tiles [part*n/parts, (part+1)*n/parts) of n,
+	// prefetching the next tile while the current one is processed. All arrays must have the same length.
+	// Tiles are ArrayViewAVX512s of the arrays, so every ValArrayAVX512 operator works on them. Prefer the in-place
+	// ones (x *= a; x += b; x.apply(avx512::clip_positive{})): the out-of-place ones (x = clip_positive(x), x = a*b + c)
+	// work too, assignment writes the result into the array, but each allocates a tile-sized temporary.
+	template<class F, class Array, class... Arrays>
+	void for_each_tile(int part, int parts, const F& f, Array& first, Arrays&... rest)
+	{
+		const int total = detail::elements(first);
+		const int tile  = detail::tile_elements<Array, Arrays...>();
+		const int count = (total + tile - 1) / tile;
+
+		const int tb = static_cast<int>(static_cast<long long>(count) * part / parts);
+		const int te = static_cast<int>(static_cast<long long>(count) * (part + 1) / parts);
+
+		for (int i = tb; i < te; ++i)
+		{
+			const int offset = i * tile;
+			const int length = std::min(tile, total - offset);
+
+			if (i + 1 < te)
+			{
+				const int next = std::min(tile, total - offset - tile);
+				detail::prefetch_range(first.begin() + offset + tile, next * sizeof(typename Array::ScalarType));
+				(detail::prefetch_range(rest.begin() + offset + tile, next * sizeof(typename Arrays::ScalarType)), ...);
+			}
+
+			detail::call_with_tiles(f,
+				ArrayViewAVX512<typename Array::ScalarType>(first.begin() + offset, length),
+				ArrayViewAVX512<typename Arrays::ScalarType>(rest.begin() + offset, length)...);
+		}
+	}
+
+	template<class F, class Array, class... Arrays>
+	void for_each_tile(const F& f, Array& first, Arrays&... rest)
+	{
+		for_each_tile(0, 1, f, first, rest...);
+	}
+
+	// Splits the tiles into one contiguous share per Dispatcher thread.
+	template<class Pool, class F, class... Arrays>
+	void parallel_for_each_tile(Pool& pool, const F& f, Arrays&... arrays)
+	{
+		pool.Parallel([&](int t) { for_each_tile(t, Pool::threads, f, arrays...); });
+	}
+}
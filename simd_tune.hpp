@@ -0,0 +1,287 @@
+#pragma once
+#include "simd_array.hpp"
+#include "simd_array_avx512.hpp"
+#include "simd_cpu.hpp"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <memory>
+#include <variant>
+#include <tuple>
+#include <limits>
+#include <algorithm>
+#include <type_traits>
+
+namespace simd
+{
+	namespace tune
+	{
+		struct Config
+		{
+			int ro = 0;
+			int threads = 0;
+			int unroll = 4;
+			std::string backend;
+		};
+
+		template<template<typename, int> typename SIMDArray> struct backend;
+		template<> struct backend<AlignedArray> { static const char* name() { return "generic"; } };
+		template<> struct backend<AlignedArrayAVX512> { static const char* name() { return "avx512"; } };
+
+		// One (RO, THREADS, backend) instantiation a TunedDispatcher may pick.
+		template<int RO, int THREADS, template<typename, int> typename SIMDArray = AlignedArrayAVX512> struct Candidate
+		{
+			template<template<class DataBatch> typename Algorithm, int Z, class Scalar>
+			using Dispatcher = cpu::Dispatcher<Algorithm, Z, Scalar, THREADS, Algorithm, RO, SIMDArray>;
+
+			template<template<class DataBatch> typename Algorithm, class Scalar>
+			using Shared = typename Algorithm<SIMDArray<Scalar, RO>>::Shared;
+
+			static bool matches(const Config& c)
+			{
+				return c.ro == RO && c.threads == THREADS && c.backend == backend<SIMDArray>::name();
+			}
+
+			static Config config(int unroll)
+			{
+				return Config{ RO, THREADS, unroll, backend<SIMDArray>::name() };
+			}
+
+			// Only the AVX-512 backend reads the unroll factor, and not for batches of 64 to 1024 bytes in powers of two:
+			// those have hand-unrolled ValArrayAVX512_Unrolled loops, sweeping them would time identical code
+			template<class Scalar> static constexpr bool unrolls()
+			{
+				constexpr size_t bytes = RO*sizeof(Scalar);
+				return std::is_same<SIMDArray<float, 64>, AlignedArrayAVX512<float, 64>>::value
+					&& !(bytes >= 64 && bytes <= 1024 && (bytes & (bytes - 1)) == 0);
+			}
+		};
+
+		inline std::string cpu_model()
+		{
+			std::ifstream in("/proc/cpuinfo");
+			std::string line;
+			while (std::getline(in, line))
+			{
+				if (line.compare(0, 10, "model name") == 0)
+				{
+					size_t colon = line.find(':');
+					if (colon != std::string::npos)
+					{
+						size_t b = line.find_first_not_of(" \t", colon + 1);
+						return b == std::string::npos ? std::string("unknown") : line.substr(b);
+					}
+				}
+			}
+			return "unknown";
+		}
+
+		// $SIMD_TUNE_PROFILE, or simd_tune.profile in the working directory
+		inline std::string default_path()
+		{
+			const char* env = std::getenv("SIMD_TUNE_PROFILE");
+			return env && *env ? env : "simd_tune.profile";
+		}
+
+		// Winning configurations, one line per (cpu model, algorithm name):
+		//   <cpu model> \t <name> \t <RO> <THREADS> <unroll> <backend>
+		// Entries for other CPUs are kept, so one file can be shared between machines.
+		class Profile
+		{
+			struct Entry
+			{
+				std::string cpu;
+				std::string name;
+				Config config;
+			};
+			std::vector<Entry> entries;
+
+		public:
+			static Profile load(const std::string& path = default_path())
+			{
+				Profile p;
+				std::ifstream in(path);
+				std::string line;
+				while (std::getline(in, line))
+				{
+					size_t t1 = line.find('\t');
+					size_t t2 = t1 == std::string::npos ? t1 : line.find('\t', t1 + 1);
+					if (t2 == std::string::npos)
+						continue;
+
+					Entry e{ line.substr(0, t1), line.substr(t1 + 1, t2 - t1 - 1), {} };
+					std::istringstream fields(line.substr(t2 + 1));
+					if (fields >> e.config.ro >> e.config.threads >> e.config.unroll >> e.config.backend)
+						p.entries.push_back(std::move(e));
+				}
+				return p;
+			}
+
+			// written next to the target and renamed over it, so concurrent readers never see half a file
+			void save(const std::string& path = default_path()) const
+			{
+				const std::string tmp = path + ".tmp";
+				{
+					std::ofstream out(tmp, std::ios::trunc);
+					for (const Entry& e : entries)
+						out << e.cpu << '\t' << e.name << '\t' << e.config.ro << ' ' << e.config.threads << ' ' << e.config.unroll << ' ' << e.config.backend << '\n';
+					if (!out)
+						throw std::runtime_error("tune::Profile: cannot write " + tmp);
+				}
+				if (std::rename(tmp.c_str(), path.c_str()) != 0)
+					throw std::runtime_error("tune::Profile: cannot replace " + path);
+			}
+
+			const Config* find(const std::string& name, const std::string& cpu = cpu_model()) const
+			{
+				for (const Entry& e : entries)
+					if (e.cpu == cpu && e.name == name)
+						return &e.config;
+				return nullptr;
+			}
+
+			void set(const std::string& name, const Config& config, const std::string& cpu = cpu_model())
+			{
+				for (Entry& e : entries)
+				{
+					if (e.cpu == cpu && e.name == name)
+					{
+						e.config = config;
+						return;
+					}
+				}
+				entries.push_back({ cpu, name, config });
+			}
+		};
+
+		// A Dispatcher whose RO, THREADS and backend are picked at startup from the profile entry for `name`
+		// on this CPU, among the compiled-in Candidates. Without an entry the first candidate is used.
+		// The unroll factor is set on the selected Dispatcher (Dispatcher::Unroll), only its Runs use it.
+		// Tune() benchmarks every candidate and unroll factor and records the fastest in the profile.
+		template<template<class DataBatch> typename Algorithm, int Z, class Scalar, class... Candidates>
+		class TunedDispatcher
+		{
+			static_assert(sizeof...(Candidates) > 0, "TunedDispatcher needs at least one candidate");
+
+			template<class C> using DispatcherOf = typename C::template Dispatcher<Algorithm, Z, Scalar>;
+			using First = std::tuple_element_t<0, std::tuple<Candidates...>>;
+
+		public:
+			using SharedData = typename First::template Shared<Algorithm, Scalar>;
+
+			explicit TunedDispatcher(const std::string& name, const std::string& path = default_path())
+			{
+				const Config* c = Profile::load(path).find(name);
+				Select(c ? *c : First::config(avx512::unroll));
+			}
+
+			explicit TunedDispatcher(const Config& config)
+			{
+				Select(config);
+			}
+
+			void Run() { std::visit([](auto& d) { d->Run(); }, mImpl); }
+
+			// Shared is usually nested in Algorithm<DataBatch> and so differs between candidates, use Visit then
+			SharedData& Shared()
+			{
+				static_assert((std::is_same<SharedData, typename Candidates::template Shared<Algorithm, Scalar>>::value && ...),
+					"candidates have different Shared types");
+				return std::visit([](auto& d) -> SharedData& { return d->Shared(); }, mImpl);
+			}
+
+			// f(cpu::Dispatcher<...>&) on the selected instantiation
+			template<class F> decltype(auto) Visit(F&& f) { return std::visit([&](auto& d) -> decltype(auto) { return f(*d); }, mImpl); }
+
+			const Config& Selected() const { return mConfig; }
+
+			// Times `reps` runs of every candidate (and every unroll factor for AVX-512 backends) after
+			// prepare(dispatcher) and one warm-up run, keeps the best time of each, stores the winner under `name`.
+			template<class Prepare>
+			static Config Tune(const std::string& name, const Prepare& prepare, int reps = 20, const std::string& path = default_path())
+			{
+				Config best;
+				double best_time = std::numeric_limits<double>::infinity();
+
+				(Measure<Candidates>(prepare, reps, best, best_time), ...);
+
+				Profile p = Profile::load(path);
+				p.set(name, best);
+				p.save(path);
+				return best;
+			}
+
+			static Config Tune(const std::string& name, int reps = 20, const std::string& path = default_path())
+			{
+				return Tune(name, [](auto&) {}, reps, path);
+			}
+
+		private:
+			std::variant<std::unique_ptr<DispatcherOf<Candidates>>...> mImpl;
+			Config mConfig;
+
+			template<size_t I = 0> void Select(const Config& c)
+			{
+				using C = std::tuple_element_t<I, std::tuple<Candidates...>>;
+				if constexpr (I + 1 < sizeof...(Candidates))
+				{
+					if (!C::matches(c))
+						return Select<I + 1>(c);
+				}
+				else
+				{
+					// a stale profile entry falls back to the first candidate
+					if (!C::matches(c))
+						return Create<0>(First::config(avx512::unroll));
+				}
+				Create<I>(c);
+			}
+
+			// profile entries with a factor the loops do not have keep the threads' default
+			static int factor(int unroll) { return (unroll == 1 || unroll == 2 || unroll == 4 || unroll == 8) ? unroll : 0; }
+
+			template<size_t I> void Create(const Config& c)
+			{
+				using C = std::tuple_element_t<I, std::tuple<Candidates...>>;
+				mConfig = c;
+				auto& d = mImpl.template emplace<I>(std::make_unique<DispatcherOf<C>>());
+				d->Unroll(C::template unrolls<Scalar>() ? factor(c.unroll) : 0);
+			}
+
+			template<class C, class Prepare>
+			static void Measure(const Prepare& prepare, int reps, Config& best, double& best_time)
+			{
+				static const int factors[] = { 1, 2, 4, 8 };
+				for (int unroll : factors)
+				{
+					if (!C::template unrolls<Scalar>() && unroll != 4)
+						continue;
+
+					auto d = std::make_unique<DispatcherOf<C>>();
+					d->Unroll(C::template unrolls<Scalar>() ? unroll : 0);
+					prepare(*d);
+					d->Run();
+
+					double t = std::numeric_limits<double>::infinity();
+					for (int r = 0; r < reps; ++r)
+					{
+						auto t0 = std::chrono::steady_clock::now();
+						d->Run();
+						t = std::min(t, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+					}
+
+					if (t < best_time)
+					{
+						best_time = t;
+						best = C::config(unroll);
+					}
+				}
+			}
+		};
+	}
+}
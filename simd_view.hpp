@@ -0,0 +1,248 @@
+#pragma once
+#include "simd_array.hpp"
+#include "simd_array_avx512.hpp"
+
+#include <immintrin.h>
+#include <cstdint>
+#include <algorithm>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace simd
+{
+	// Non-owning window over n contiguous scalars anywhere in memory: the begin()/end() contract of ValArray,
+	// so the in-place operators (+=, *=, apply, zip, ...) work on it directly. Copy construction gives another view
+	// of the same memory, assignment copies elements into it; the operators that return a new array (a + b, abs(a), ...)
+	// are deleted, copy into an owning array for those.
+	template<class Scalar> class ArrayView : public ValArray<ArrayView<Scalar>, Scalar>
+	{
+		Scalar* data = nullptr;
+		int Z = 0;
+	public:
+		using ScalarType = Scalar;
+
+		ArrayView() = default;
+		ArrayView(Scalar* mem, int sz) : data(mem), Z(sz) {}
+
+		template<class Array, class = decltype(std::declval<Array&>().begin())>
+		ArrayView(Array& a) : data(a.begin()), Z(int(a.end() - a.begin())) {}
+
+		ArrayView(const ArrayView&) = default;
+
+		ArrayView& operator=(const Scalar& rhs) { return ValArray<ArrayView<Scalar>, Scalar>::operator=(rhs); }
+		ArrayView& operator=(const ArrayView& rhs) { return assign(rhs); }
+
+		// element-wise copy of rhs into the viewed memory
+		ArrayView& assign(const ArrayView& rhs) { return this->zip(rhs, [](const Scalar&, const Scalar& b) { return b; }); }
+
+		ArrayView clone() const = delete;
+		ArrayView operator+(const ArrayView&) const = delete;
+		ArrayView operator-(const ArrayView&) const = delete;
+		ArrayView operator*(const ArrayView&) const = delete;
+		ArrayView operator/(const ArrayView&) const = delete;
+		ArrayView operator+(const Scalar&) const = delete;
+		ArrayView operator-(const Scalar&) const = delete;
+		ArrayView operator*(const Scalar&) const = delete;
+		ArrayView operator/(const Scalar&) const = delete;
+
+		int size() const { return Z; }
+
+		Scalar* begin() const { return data; }
+		Scalar* end() const { return data + Z; }
+
+		Scalar& operator[](int index) const { return data[index]; }
+
+		ArrayView subview(int offset, int sz) const { return ArrayView(data + offset, sz); }
+
+		Scalar fold() const
+		{
+			Scalar res{};
+			for (int i = 0; i < Z; ++i) res += data[i];
+			return res;
+		}
+	};
+
+	// ArrayView with the AVX-512 kernels of ValArrayAVX512. The memory needs no particular alignment and the
+	// length need not be a whole number of registers: the part before the first 64-byte boundary and the part
+	// after the last whole register go through masked loads and stores, nothing outside [begin, end) is touched.
+	// This is also the tile type of for_each_tile (simd_tiles.hpp).
+	// All ValArrayAVX512 operators work. The in-place ones (+=, *=, apply, zip, scans, ...) write the viewed memory;
+	// the out-of-place ones (a + b, 2.f * a, clip_positive(a), abs(a), exp2(a), ...) return a view of a fresh copy,
+	// which allocates, and assigning that to a view copies it back: x = clip_positive(x) updates x's memory.
+	template<class Scalar> class ArrayViewAVX512 : public ValArrayAVX512<ArrayViewAVX512<Scalar>, Scalar, 0>
+	{
+		Scalar* data = nullptr;
+		int Z = 0;
+		std::shared_ptr<Scalar> owner;	// set on results of clone(), shared by their copies and subviews
+	public:
+		using ScalarType = Scalar;
+
+		ArrayViewAVX512() = default;
+		ArrayViewAVX512(Scalar* mem, int sz) : data(mem), Z(sz) {}
+
+		template<class Array, class = decltype(std::declval<Array&>().begin()),
+			class = std::enable_if_t<!std::is_same<std::decay_t<Array>, ArrayViewAVX512>::value>>
+		ArrayViewAVX512(Array& a) : data(a.begin()), Z(int(a.end() - a.begin())) {}
+
+		ArrayViewAVX512(const ArrayViewAVX512&) = default;
+
+		ArrayViewAVX512& operator=(const Scalar& rhs) { return ValArrayAVX512<ArrayViewAVX512<Scalar>, Scalar, 0>::operator=(rhs); }
+		ArrayViewAVX512& operator=(const ArrayViewAVX512& rhs) { return assign(rhs); }
+
+		// element-wise copy of rhs into the viewed memory
+		ArrayViewAVX512& assign(const ArrayViewAVX512& rhs) { return this->zip(rhs, avx512::fill{}); }
+
+		// a view of a 64-byte aligned copy of the elements, freed with its last view
+		ArrayViewAVX512 clone() const
+		{
+			std::pmr::memory_resource* res = std::pmr::get_default_resource();
+			const size_t bytes = std::max<size_t>((size_t(Z)*sizeof(Scalar) + 63) & ~size_t(63), 64);
+			Scalar* mem = static_cast<Scalar*>(res->allocate(bytes, 64));
+			std::copy(begin(), end(), mem);
+
+			ArrayViewAVX512 r(mem, Z);
+			r.owner = std::shared_ptr<Scalar>(mem, [res, bytes](Scalar* p) { res->deallocate(p, bytes, 64); });
+			return r;
+		}
+
+		int size() const { return Z; }
+
+		Scalar* begin() const { return data; }
+		Scalar* end() const { return data + Z; }
+
+		Scalar& operator[](int index) const { return data[index]; }
+
+		ArrayViewAVX512 subview(int offset, int sz) const
+		{
+			ArrayViewAVX512 r(data + offset, sz);
+			r.owner = owner;
+			return r;
+		}
+
+		Scalar fold() const
+		{
+			Scalar res{};
+			for (int i = 0; i < Z; ++i) res += data[i];
+			return res;
+		}
+	};
+
+	namespace detail
+	{
+		template<class Scalar> struct StrideOps {};
+
+		template<> struct StrideOps<float>
+		{
+			static const int L = 16;
+			static __m512i index(int stride) { return _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15), _mm512_set1_epi32(stride)); }
+			static void gather(const float* p, __m512i idx, float* out, int n)  { _mm512_mask_storeu_ps(out, __mmask16((1u << n) - 1), _mm512_mask_i32gather_ps(_mm512_setzero_ps(), __mmask16((1u << n) - 1), idx, p, 4)); }
+			static void scatter(float* p, __m512i idx, const float* in, int n) { _mm512_mask_i32scatter_ps(p, __mmask16((1u << n) - 1), idx, _mm512_maskz_loadu_ps(__mmask16((1u << n) - 1), in), 4); }
+		};
+
+		template<> struct StrideOps<int>
+		{
+			static const int L = 16;
+			static __m512i index(int stride) { return StrideOps<float>::index(stride); }
+			static void gather(const int* p, __m512i idx, int* out, int n)  { _mm512_mask_storeu_epi32(out, __mmask16((1u << n) - 1), _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), __mmask16((1u << n) - 1), idx, p, 4)); }
+			static void scatter(int* p, __m512i idx, const int* in, int n) { _mm512_mask_i32scatter_epi32(p, __mmask16((1u << n) - 1), idx, _mm512_maskz_loadu_epi32(__mmask16((1u << n) - 1), in), 4); }
+		};
+
+		template<> struct StrideOps<double>
+		{
+			static const int L = 8;
+			static __m512i index(int stride) { return _mm512_castsi256_si512(_mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride))); }
+			static void gather(const double* p, __m512i idx, double* out, int n)  { _mm512_mask_storeu_pd(out, __mmask8((1u << n) - 1), _mm512_mask_i32gather_pd(_mm512_setzero_pd(), __mmask8((1u << n) - 1), _mm512_castsi512_si256(idx), p, 8)); }
+			static void scatter(double* p, __m512i idx, const double* in, int n) { _mm512_mask_i32scatter_pd(p, __mmask8((1u << n) - 1), _mm512_castsi512_si256(idx), _mm512_maskz_loadu_pd(__mmask8((1u << n) - 1), in), 8); }
+		};
+	}
+
+	// Every stride-th scalar, e.g. a matrix column. Element-wise ops run through ValArray's iterator loops;
+	// gather()/scatter() move the elements to and from contiguous memory with AVX-512 gathers and scatters,
+	// for work that is better done on an ArrayViewAVX512 of a scratch buffer.
+	template<class Scalar> class StridedView : public ValArray<StridedView<Scalar>, Scalar>
+	{
+		Scalar* data = nullptr;
+		int Z = 0;
+		int step = 1;
+	public:
+		using ScalarType = Scalar;
+
+		class iterator
+		{
+			Scalar* p;
+			int step;
+		public:
+			iterator(Scalar* ptr, int s) : p(ptr), step(s) {}
+
+			Scalar& operator*() const { return *p; }
+			Scalar& operator[](int i) const { return p[i*step]; }
+			iterator& operator++() { p += step; return *this; }
+			iterator operator++(int) { iterator r = *this; p += step; return r; }
+			bool operator==(const iterator& rhs) const { return p == rhs.p; }
+			bool operator!=(const iterator& rhs) const { return p != rhs.p; }
+		};
+
+		StridedView() = default;
+		StridedView(Scalar* mem, int sz, int stride) : data(mem), Z(sz), step(stride)
+		{
+			// gathers address a register's lanes with 32-bit offsets
+			if (stride <= 0 || stride > INT32_MAX / 16)
+				throw std::invalid_argument("StridedView: stride out of range");
+		}
+
+		StridedView(const StridedView&) = default;
+
+		StridedView& operator=(const Scalar& rhs) { return ValArray<StridedView<Scalar>, Scalar>::operator=(rhs); }
+		StridedView& operator=(const StridedView& rhs) { return assign(rhs); }
+
+		StridedView& assign(const StridedView& rhs) { return this->zip(rhs, [](const Scalar&, const Scalar& b) { return b; }); }
+
+		StridedView clone() const = delete;
+		StridedView operator+(const StridedView&) const = delete;
+		StridedView operator-(const StridedView&) const = delete;
+		StridedView operator*(const StridedView&) const = delete;
+		StridedView operator/(const StridedView&) const = delete;
+		StridedView operator+(const Scalar&) const = delete;
+		StridedView operator-(const Scalar&) const = delete;
+		StridedView operator*(const Scalar&) const = delete;
+		StridedView operator/(const Scalar&) const = delete;
+
+		int size() const { return Z; }
+		int stride() const { return step; }
+
+		iterator begin() const { return iterator(data, step); }
+		iterator end() const { return iterator(data + size_t(Z)*step, step); }
+
+		Scalar& operator[](int index) const { return data[size_t(index)*step]; }
+
+		Scalar fold() const
+		{
+			Scalar res{};
+			for (int i = 0; i < Z; ++i) res += data[size_t(i)*step];
+			return res;
+		}
+
+		// out[i] = (*this)[i]
+		void gather(Scalar* out) const
+		{
+			using Ops = detail::StrideOps<Scalar>;
+			const __m512i idx = Ops::index(step);
+			const Scalar* p = data;
+			for (int i = 0; i < Z; i += Ops::L, p += size_t(Ops::L)*step)
+				Ops::gather(p, idx, out + i, std::min(Ops::L, Z - i));
+		}
+
+		// (*this)[i] = in[i]
+		void scatter(const Scalar* in) const
+		{
+			using Ops = detail::StrideOps<Scalar>;
+			const __m512i idx = Ops::index(step);
+			Scalar* p = data;
+			for (int i = 0; i < Z; i += Ops::L, p += size_t(Ops::L)*step)
+				Ops::scatter(p, idx, in + i, std::min(Ops::L, Z - i));
+		}
+	};
+}